@@ -0,0 +1,233 @@
+// Benchmark for int2048, mirroring the workload classes of problems 2014-2019.
+//
+// Build from the repository root (add -fopenmp to exercise int2048::setThreads):
+//   g++ -O2 -std=c++17 -Isrc/include bench/bench.cpp src/int2048.cpp -o int2048_bench
+//
+// Usage:
+//   int2048_bench [--quick] [--threads N] [filter]   run cases whose name contains filter
+//   int2048_bench --compare base.csv new.csv         diff two runs, exit 1 on regression
+//
+// Output is CSV on stdout, one row per case, followed by a peak_rss_kib row:
+//   case,digits_a,digits_b,ns_per_op,limbs_per_s,scratch_bytes
+// ns_per_op is the median over several batches of deterministic operands, so two
+// runs of the same build on the same host should agree to within a few percent.
+
+#include "int2048.h"
+
+#include <sys/resource.h>
+
+#include <algorithm>
+#include <chrono>
+#include <cstdlib>
+#include <fstream>
+#include <map>
+#include <random>
+#include <sstream>
+#include <string>
+#include <vector>
+
+using sjtu::int2048;
+
+namespace {
+
+enum Op { ADD, SUB, MUL, SQR, DIV, MOD, GCD, XGCD, ISQRT, PARSE, PRINT };
+
+struct Case {
+  const char *name;
+  size_t digitsA, digitsB;
+  Op op;
+};
+
+// grouped by the problem whose limits they mirror
+const Case CASES[] = {
+    // 2014/2015 basic: |values| <= 10^1000
+    {"basic_add", 1000, 1000, ADD},
+    {"basic_sub", 1000, 999, SUB},
+    {"basic_mul", 500, 500, MUL},
+    {"basic_div", 1000, 500, DIV},
+    {"basic_mod", 1000, 500, MOD},
+    {"basic_parse", 1000, 0, PARSE},
+    {"basic_print", 1000, 0, PRINT},
+    // 2016 digit compression: |values| <= 10^30000, divisors <= 10^3000
+    {"compress_add", 30000, 30000, ADD},
+    {"compress_mul", 15000, 15000, MUL},
+    {"compress_mul_unbalanced", 27000, 3000, MUL},
+    {"compress_div", 30000, 3000, DIV},
+    {"compress_mod", 30000, 3000, MOD},
+    {"compress_gcd", 30000, 30000, GCD},
+    {"compress_xgcd", 30000, 30000, XGCD},
+    // 2017 multiplication speed: |values| <= 10^200000
+    {"mul_speed", 100000, 100000, MUL},
+    {"mul_speed_sqr", 100000, 0, SQR},
+    // 2018 division speed: |values| <= 10^12000
+    {"div_speed_balanced", 12000, 6000, DIV},
+    {"div_speed_below_2m", 11991, 6000, DIV}, // 1333 by 667 limbs: n = 2m - 1
+    {"div_speed_small_divisor", 12000, 1000, DIV},
+    {"div_speed_mod", 12000, 6000, MOD},
+    // 2019 stress: |values| <= 10^500000
+    {"stress_add", 500000, 500000, ADD},
+    {"stress_sub", 500000, 499999, SUB},
+    {"stress_mul", 200000, 200000, MUL},
+    {"stress_mul_unbalanced", 200000, 3000, MUL},
+    {"stress_div", 400000, 200000, DIV},
+    {"stress_div_unbalanced", 200000, 3000, DIV},
+    {"stress_parse", 500000, 0, PARSE},
+    {"stress_print", 500000, 0, PRINT},
+    // size sweeps from 10^3 to 10^200000
+    {"sweep_mul", 1000, 1000, MUL},
+    {"sweep_mul", 3000, 3000, MUL},
+    {"sweep_mul", 10000, 10000, MUL},
+    {"sweep_mul", 30000, 30000, MUL},
+    {"sweep_mul", 100000, 100000, MUL},
+    {"sweep_mul", 200000, 200000, MUL},
+    {"sweep_div", 2000, 1000, DIV},
+    {"sweep_div", 6000, 3000, DIV},
+    {"sweep_div", 20000, 10000, DIV},
+    {"sweep_div", 60000, 30000, DIV},
+    {"sweep_div", 200000, 100000, DIV},
+    {"sweep_gcd", 1000, 1000, GCD},
+    {"sweep_gcd", 10000, 10000, GCD},
+    {"sweep_gcd", 100000, 100000, GCD},
+    {"sweep_isqrt", 1000, 0, ISQRT},
+    {"sweep_isqrt", 10000, 0, ISQRT},
+    {"sweep_isqrt", 100000, 0, ISQRT},
+};
+
+std::string randomDigits(std::mt19937_64 &rng, size_t n) {
+  std::string s(n, '0');
+  for (size_t i = 0; i < n; ++i) s[i] = static_cast<char>('0' + rng() % 10);
+  if (n > 0) s[0] = static_cast<char>('1' + rng() % 9);
+  return s;
+}
+
+size_t limbsOf(size_t digits) { return (digits + 8) / 9; }
+
+double nowNs() {
+  return std::chrono::duration<double, std::nano>(
+             std::chrono::steady_clock::now().time_since_epoch())
+      .count();
+}
+
+volatile size_t keepAlive; // stops the timed operations from being optimized out
+
+struct Result {
+  double nsPerOp;
+  size_t scratchBytes;
+};
+
+Result runCase(const Case &c, bool quick) {
+  std::mt19937_64 rng(c.digitsA * 1000003u + c.digitsB);
+  const std::string textA = randomDigits(rng, c.digitsA);
+  const int2048 a(textA);
+  const int2048 b(randomDigits(rng, c.digitsB));
+  std::vector<char> out(a.decimalLength() + 1);
+  int2048 r, x, y;
+  size_t sink = 0;
+
+  auto once = [&]() {
+    switch (c.op) {
+    case ADD: r = a + b; break;
+    case SUB: r = a - b; break;
+    case MUL: r = a * b; break;
+    case SQR: r = sqr(a); break;
+    case DIV: r = a / b; break;
+    case MOD: r = a % b; break;
+    case GCD: r = gcd(a, b); break;
+    case XGCD: r = xgcd(a, b, x, y); break;
+    case ISQRT: r = isqrt(a); break;
+    case PARSE: r.read(textA.data(), textA.size()); break;
+    case PRINT: sink += a.to_chars(out.data(), out.data() + out.size()) - out.data(); break;
+    }
+  };
+
+  int2048::resetScratchPeak();
+  once(); // warm up caches and the scratch arena
+  // size a batch to take about 20 ms, then keep the median batch
+  size_t reps = 1;
+  for (;;) {
+    double t = nowNs();
+    for (size_t i = 0; i < reps; ++i) once();
+    if (nowNs() - t > 2e7 || reps >= (size_t(1) << 24)) break;
+    reps *= 2;
+  }
+  const int batches = quick ? 3 : 7;
+  std::vector<double> perOp;
+  for (int k = 0; k < batches; ++k) {
+    double t = nowNs();
+    for (size_t i = 0; i < reps; ++i) once();
+    perOp.push_back((nowNs() - t) / reps);
+  }
+  std::sort(perOp.begin(), perOp.end());
+  keepAlive = sink + r.decimalLength();
+  return Result{perOp[perOp.size() / 2], int2048::scratchPeak()};
+}
+
+long peakRssKib() {
+  struct rusage usage;
+  getrusage(RUSAGE_SELF, &usage);
+  return usage.ru_maxrss; // KiB on Linux
+}
+
+// case key -> ns_per_op from a CSV written by this program
+std::map<std::string, double> loadRun(const char *path) {
+  std::map<std::string, double> run;
+  std::ifstream in(path);
+  std::string line;
+  while (std::getline(in, line)) {
+    std::vector<std::string> cols;
+    std::stringstream ss(line);
+    for (std::string col; std::getline(ss, col, ',');) cols.push_back(col);
+    if (cols.size() < 4 || cols[0] == "case" || cols[0] == "peak_rss_kib") continue;
+    run[cols[0] + "," + cols[1] + "," + cols[2]] = std::atof(cols[3].c_str());
+  }
+  return run;
+}
+
+int compareRuns(const char *basePath, const char *newPath) {
+  const double tolerance = 1.10; // slower than this counts as a regression
+  std::map<std::string, double> base = loadRun(basePath), cur = loadRun(newPath);
+  int regressions = 0;
+  std::printf("case,digits_a,digits_b,base_ns,new_ns,ratio\n");
+  for (std::map<std::string, double>::const_iterator it = cur.begin(); it != cur.end(); ++it) {
+    std::map<std::string, double>::const_iterator old = base.find(it->first);
+    if (old == base.end() || old->second <= 0) continue;
+    double ratio = it->second / old->second;
+    bool slower = ratio > tolerance;
+    regressions += slower;
+    std::printf("%s,%.0f,%.0f,%.3f%s\n", it->first.c_str(), old->second, it->second, ratio,
+                slower ? ",REGRESSION" : "");
+  }
+  std::fprintf(stderr, "%d regression(s) above %.0f%%\n", regressions, (tolerance - 1) * 100);
+  return regressions ? 1 : 0;
+}
+
+} // namespace
+
+int main(int argc, char **argv) {
+  if (argc == 4 && std::string(argv[1]) == "--compare") return compareRuns(argv[2], argv[3]);
+
+  bool quick = false;
+  std::string filter;
+  for (int i = 1; i < argc; ++i) {
+    std::string arg = argv[i];
+    if (arg == "--quick") {
+      quick = true;
+    } else if (arg == "--threads" && i + 1 < argc) {
+      int2048::setThreads(std::atoi(argv[++i]));
+    } else {
+      filter = arg;
+    }
+  }
+
+  std::printf("case,digits_a,digits_b,ns_per_op,limbs_per_s,scratch_bytes\n");
+  for (const Case &c : CASES) {
+    if (!filter.empty() && std::string(c.name).find(filter) == std::string::npos) continue;
+    Result res = runCase(c, quick);
+    double limbs = static_cast<double>(limbsOf(c.digitsA) + limbsOf(c.digitsB));
+    std::printf("%s,%zu,%zu,%.0f,%.4g,%zu\n", c.name, c.digitsA, c.digitsB, res.nsPerOp,
+                limbs / res.nsPerOp * 1e9, res.scratchBytes);
+    std::fflush(stdout);
+  }
+  std::printf("peak_rss_kib,%ld\n", peakRssKib());
+  return 0;
+}
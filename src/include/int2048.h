@@ -18,29 +18,214 @@
 // 请不要使用 using namespace std;
 
 namespace sjtu {
+// built-in integer types accepted by int2048's mixed-type operators; the
+// member 'type' (the operator's result type R) exists only for those types
+template <class T, class R> struct IntegralOperand {};
+template <class T, class R> struct SignedOperand {
+  typedef R type;
+  static unsigned long long split(T v, bool &negative) {
+    negative = v < 0;
+    return negative ? 0ull - static_cast<unsigned long long>(v) : static_cast<unsigned long long>(v);
+  }
+};
+template <class T, class R> struct UnsignedOperand {
+  typedef R type;
+  static unsigned long long split(T v, bool &negative) {
+    negative = false;
+    return v;
+  }
+};
+template <class R> struct IntegralOperand<signed char, R> : SignedOperand<signed char, R> {};
+template <class R> struct IntegralOperand<short, R> : SignedOperand<short, R> {};
+template <class R> struct IntegralOperand<int, R> : SignedOperand<int, R> {};
+template <class R> struct IntegralOperand<long, R> : SignedOperand<long, R> {};
+template <class R> struct IntegralOperand<long long, R> : SignedOperand<long long, R> {};
+template <class R> struct IntegralOperand<unsigned char, R> : UnsignedOperand<unsigned char, R> {};
+template <class R> struct IntegralOperand<unsigned short, R> : UnsignedOperand<unsigned short, R> {};
+template <class R> struct IntegralOperand<unsigned, R> : UnsignedOperand<unsigned, R> {};
+template <class R> struct IntegralOperand<unsigned long, R> : UnsignedOperand<unsigned long, R> {};
+template <class R>
+struct IntegralOperand<unsigned long long, R> : UnsignedOperand<unsigned long long, R> {};
+
 class int2048 {
 private:
   static const uint32_t BASE = 1000000000u; // 1e9
   static const int BASE_DIGS = 9;
-  std::vector<uint32_t> digits; // little-endian, digits[0] is least significant
-  bool negative = false;        // true if value < 0
+
+  // limb array with the std::vector interface used below; values of up to
+  // INLINE_LIMBS limbs live inside the object and never touch the heap
+  class Limbs {
+  public:
+    static const size_t INLINE_LIMBS = 4;
+
+    Limbs();
+    Limbs(const Limbs &other);
+    Limbs(Limbs &&other) noexcept;
+    ~Limbs();
+    Limbs &operator=(const Limbs &other);
+    Limbs &operator=(Limbs &&other) noexcept;
+
+    size_t size() const;
+    size_t capacity() const;
+    bool empty() const;
+    uint32_t *data();
+    const uint32_t *data() const;
+    uint32_t *begin();
+    uint32_t *end();
+    const uint32_t *begin() const;
+    const uint32_t *end() const;
+    uint32_t &operator[](size_t i);
+    const uint32_t &operator[](size_t i) const;
+    uint32_t &back();
+    const uint32_t &back() const;
+
+    void reserve(size_t n);
+    void resize(size_t n, uint32_t value = 0);
+    void assign(size_t n, uint32_t value);
+    void assign(const uint32_t *first, const uint32_t *last);
+    void clear();
+    void push_back(uint32_t value);
+    void pop_back();
+    void insert(uint32_t *pos, size_t n, uint32_t value);
+    void erase(uint32_t *first, uint32_t *last);
+    void swap(Limbs &other);
+    bool operator==(const Limbs &other) const;
+
+  private:
+    bool isInline() const;
+
+    uint32_t *ptr; // either buf or a heap block of cap limbs
+    size_t len;
+    size_t cap;
+    uint32_t buf[INLINE_LIMBS];
+  };
+
+  Limbs digits;          // little-endian, digits[0] is least significant
+  bool negative = false; // true if value < 0
 
   // helpers on absolute values (sign-agnostic)
   void trim();
   bool isZero() const;
+  void shiftLimbsLeft(size_t k);  // |*this| *= BASE^k
+  void shiftLimbsRight(size_t k); // |*this| /= BASE^k, truncating
+  void truncateLimbs(size_t k);   // |*this| %= BASE^k
   int absCompare(const int2048 &other) const; // -1,0,1 for |*this| cmp |other|
   void absAdd(const int2048 &other);          // |*this| += |other|
   void absSub(const int2048 &other);          // |*this| -= |other|, require |*this|>=|other|
+  void absSubFrom(const int2048 &other);      // |*this| = |other| - |*this|, require |other|>=|*this|
+  // *this += (otherNegative ? -|other| : |other|) without copying other
+  int2048 &addSigned(const int2048 &other, bool otherNegative);
+  // *this += (productNegative ? -|a*b| : |a*b|), the body of addMul/subMul
+  int2048 &mulAccumulate(const int2048 &a, const int2048 &b, bool productNegative);
 
   static int2048 absAdd(const int2048 &a, const int2048 &b);
   static int2048 absSubLargeSmall(const int2048 &a, const int2048 &b); // assume |a|>=|b|
 
-  static void mulSchoolbook(const std::vector<uint32_t> &a,
-                            const std::vector<uint32_t> &b,
-                            std::vector<uint32_t> &out);
+  // multiplication tiers, chosen by the length of the shorter operand:
+  // schoolbook below KARATSUBA_THRESHOLD, Karatsuba below NTT_THRESHOLD,
+  // number-theoretic transform above
+  static const size_t KARATSUBA_THRESHOLD = 64;
+  static const size_t NTT_THRESHOLD = 3000;
 
-  // division with trunc toward zero: returns (q, r) such that a = b*q + r, 0<=|r|<|b|
-  static void divmodTrunc(const int2048 &a, const int2048 &b, int2048 &q, int2048 &r);
+  // raw limb kernels; x/out must not overlap the inputs
+  static uint32_t addLimbs(uint32_t *x, size_t xn, const uint32_t *y, size_t yn); // x += y, returns carry
+  static uint32_t subLimbs(uint32_t *x, size_t xn, const uint32_t *y, size_t yn); // x -= y, returns borrow
+  static int compareLimbs(const uint32_t *x, const uint32_t *y, size_t n); // -1,0,1 for x cmp y
+  // out[0, n+m) = a*b; requires n >= m and m <= KARATSUBA_THRESHOLD
+  static void mulBasecase(const uint32_t *a, size_t n, const uint32_t *b, size_t m,
+                          uint32_t *out);
+  // requires n >= m; scratch must hold karatsubaScratch(n, m) limbs
+  static void mulKaratsuba(const uint32_t *a, size_t n, const uint32_t *b, size_t m,
+                           uint32_t *out, uint32_t *scratch);
+  static size_t karatsubaScratch(size_t n, size_t m);
+  // squaring counterparts: each cross product a[i]*a[j] is formed once
+  // out[0, 2n) = a^2; requires n <= KARATSUBA_THRESHOLD
+  static void sqrBasecase(const uint32_t *a, size_t n, uint32_t *out);
+  static void sqrKaratsuba(const uint32_t *a, size_t n, uint32_t *out, uint32_t *scratch);
+  static size_t sqrScratch(size_t n);
+
+  // |a| * |b| with tier selection, trimmed
+  static void mulAbs(const Limbs &a, const Limbs &b, Limbs &out);
+  static void sqrAbs(const Limbs &a, Limbs &out);
+  static void mulSchoolbook(const Limbs &a, const Limbs &b, Limbs &out);
+  // three-prime NTT convolution recombined by CRT, exact for any size we use;
+  // passing the same vector twice transforms it only once
+  static void mulNTT(const Limbs &a, const Limbs &b, Limbs &out);
+
+  static uint32_t mulWord(uint32_t *x, size_t n, uint32_t w); // x *= w, returns carry
+  static uint32_t divWord(uint32_t *x, size_t n, uint32_t w); // x /= w (any w > 0), returns remainder
+  // Knuth's Algorithm D on u[0, n] (n+1 limbs) by normalized v (m >= 2 limbs,
+  // v[m-1] >= BASE/2): q[0, n-m] gets the quotient, u[0, m) the remainder
+  static void divKnuth(uint32_t *u, size_t n, const uint32_t *v, size_t m, uint32_t *q);
+
+  // reciprocals of at least this many limbs are refined by Newton's iteration
+  // from the reciprocal of their top half; shorter ones take one division
+  static const size_t NEWTON_THRESHOLD = 800;
+
+  // divisions whose divisor and quotient both reach BZ_THRESHOLD limbs go
+  // through Burnikel-Ziegler block recursion; its leaves are at most this big
+  static const size_t BZ_THRESHOLD = 80;
+
+  // Burnikel-Ziegler on non-negative values; b is normalized with n limbs
+  static void divBZ(const int2048 &a, const int2048 &b, int2048 &q, int2048 &r);
+  static void div2n1n(const int2048 &a, const int2048 &b, size_t n, int2048 &q, int2048 &r);
+  static void div3n2n(const int2048 &a, const int2048 &b, size_t half, int2048 &q, int2048 &r);
+
+  // floor(BASE^(2k) / b) for a non-negative k-limb b, by Newton iteration
+  static int2048 reciprocal(const int2048 &b);
+
+  // |a| = |b|*q + r by Algorithm D, q and r non-negative
+  static void divSchool(const int2048 &a, const int2048 &b, int2048 &q, int2048 &r);
+
+  // gcd machinery. A reduction replaces (a, b), a >= b >= 0, by
+  // (n0*a + n1*b, n2*a + n3*b) for a unimodular n and keeps a >= b >= 0;
+  // cofactor pairs (x, y) tracked alongside go through the same n.
+  // Pairs of at least HGCD_THRESHOLD limbs take the half-gcd recursion
+  static const size_t HGCD_THRESHOLD = 150;
+
+  // Lehmer: w from the top two limbs of a (b aligned to them), whose
+  // quotients are provably those of a and b and keep the new b at least
+  // floor in those units; false if not even one quotient is certain
+  static bool lehmerMatrix(const int2048 &a, const int2048 &b, uint64_t floor, int64_t w[4]);
+  static void applyLehmer(int2048 &a, int2048 &b, const int64_t w[4]);
+  // any word matrix on a cofactor pair; a Lehmer w on a pair of opposite
+  // signs, the usual case, only adds magnitudes and takes one pass
+  static void applyLehmerSigned(int2048 &x, int2048 &y, const int64_t w[4]);
+  // (a, b) = (b, a % b) with the quotient applied to the pairs at x[0..pairs)
+  // and y[0..pairs) (x[i] for a's row, y[i] for b's)
+  static void euclidStep(int2048 &a, int2048 &b, int2048 *x, int2048 *y, size_t pairs);
+  // reduces b below about BASE^(n/2 + 1) for an n-limb a; m = {n0, n1, n2, n3}
+  static void hgcd(int2048 &a, int2048 &b, int2048 m[4]);
+  // hgcd on the limbs of a and b above the lowest k, applied to the whole
+  static void hgcdTop(int2048 &a, int2048 &b, size_t k, int2048 m[4]);
+  // (a, b) -> (gcd, 0); u, if given, is one cofactor pair carried along
+  static void gcdReduce(int2048 &a, int2048 &b, int2048 *u);
+
+  // floor(a^(1/k)) for a > 0 and k >= 2 by Newton's iteration from above,
+  // started from the root of a's top limbs (found the same way) or a double;
+  // unless exact, the result may also be a unit or two above the floor
+  static int2048 rootAbs(const int2048 &a, unsigned long long k, bool exact);
+
+  // kernels behind the mixed-type operators; the operand is ±mag, and
+  // single-limb (add, mul) or 32-bit (div, mod) magnitudes take one pass
+  static int2048 fromSmall(uint64_t mag, bool neg);
+  static uint32_t modWord(const uint32_t *x, size_t n, uint32_t w); // x % w
+  void negate();
+  int2048 &addSmall(uint64_t mag, bool neg);
+  int2048 &mulSmall(uint64_t mag, bool neg);
+  int2048 &divSmall(uint64_t mag, bool neg); // floor, like operator/=
+  int2048 &modSmall(uint64_t mag, bool neg); // floor, like operator%=
+  int compareSmall(uint64_t mag, bool neg) const;
+
+  // one chunk of evaluate(): lines [first, last), results appended to out
+  static void evaluateLines(const char *first, const char *last, std::string &out);
+  template <class T> int compareTo(T v) const {
+    bool neg;
+    uint64_t mag = IntegralOperand<T, int>::split(v, neg);
+    return compareSmall(mag, neg);
+  }
+
+  friend class int2048_divisor;
 
 public:
   // 构造函数
@@ -48,6 +233,7 @@ public:
   int2048(long long);
   int2048(const std::string &);
   int2048(const int2048 &);
+  int2048(int2048 &&) noexcept;
 
   // 以下给定函数的形式参数类型仅供参考，可自行选择使用常量引用或者不使用引用
   // 如果需要，可以自行增加其他所需的函数
@@ -57,8 +243,15 @@ public:
 
   // 读入一个大整数
   void read(const std::string &);
+  // 从长度为 len 的字符数组读入，不要求以 '\0' 结尾
+  void read(const char *, size_t);
   // 输出储存的大整数，无需换行
   void print();
+  // 十进制表示的字符数（含负号）
+  size_t decimalLength() const;
+  // 把十进制表示写入 [first, last)，不写 '\0'；返回写入末尾的下一位置，
+  // 空间不足时返回 nullptr 且不写入任何内容
+  char *to_chars(char *first, char *last) const;
 
   // 加上一个大整数
   int2048 &add(const int2048 &);
@@ -78,15 +271,48 @@ public:
   int2048 operator-() const;
 
   int2048 &operator=(const int2048 &);
+  int2048 &operator=(int2048 &&) noexcept;
 
   int2048 &operator+=(const int2048 &);
   friend int2048 operator+(int2048, const int2048 &);
+  friend int2048 operator+(const int2048 &, int2048 &&); // 复用右侧临时量的空间
 
   int2048 &operator-=(const int2048 &);
   friend int2048 operator-(int2048, const int2048 &);
+  friend int2048 operator-(const int2048 &, int2048 &&);
 
   int2048 &operator*=(const int2048 &);
-  friend int2048 operator*(int2048, const int2048 &);
+  friend int2048 operator*(const int2048 &, const int2048 &);
+
+  // 平方，x.sqr() 与 x *= x 等价，但交叉项只计算一次
+  int2048 &sqr();
+  friend int2048 sqr(const int2048 &);
+
+  // 乘加：x.addMul(a, b) 与 x += a * b 等价，x.subMul(a, b) 与 x -= a * b 等价，
+  // 但乘积不构造临时对象，直接累加到 x 上
+  int2048 &addMul(const int2048 &, const int2048 &);
+  int2048 &subMul(const int2048 &, const int2048 &);
+
+  // 乘除法内部的临时空间来自每个线程一块可复用的暂存区
+  // 返回自上次重置以来暂存区的峰值占用（字节）
+  static size_t scratchPeak();
+  static void resetScratchPeak();
+  // 设置运算结束后暂存区最多保留的字节数（默认 8 MiB），多余部分归还给系统。
+  // 这只是保留阈值而非上限：单次运算需要多少暂存空间仍会分配多少。运算中途
+  // 无法在不出错的前提下拒绝分配（本库不报告错误），因此不提供硬上限；
+  // 单次运算的峰值由操作数规模决定，可用 scratchPeak() 测得
+  static void setScratchRetention(size_t bytes);
+
+  // 可选的并行模式（需以 -fopenmp 编译，否则始终串行）：乘法使用至多 threads
+  // 个线程，默认为 1 即串行；较短操作数不少于 limbs 个压位（默认 256）时才并行。
+  // 并行与串行的结果完全相同
+  static void setThreads(int threads);
+  static void setParallelThreshold(size_t limbs);
+
+  // 性能统计（需以 -DINT2048_STATS 编译，否则不产生任何开销）：各内部算法的调用
+  // 次数、处理的压位数、周期数与规模直方图，商估计修正与内存分配次数
+  static void dumpStats(std::ostream &);
+  static void resetStats();
 
   int2048 &operator/=(const int2048 &);
   friend int2048 operator/(int2048, const int2048 &);
@@ -94,15 +320,183 @@ public:
   int2048 &operator%=(const int2048 &);
   friend int2048 operator%(int2048, const int2048 &);
 
+  // 一次除法同时得到商和余数：a = b * q + r，要求 b != 0。
+  // divmodTrunc 向零取整（r 与 a 同号），divmodFloor 与 / 和 % 一样向下取整
+  // （r 与 b 同号），divmod 即 divmodFloor。结果直接写入 q 和 r 原有的空间，
+  // q 与 r 可以是 a 或 b 本身（但不能是同一个对象）
+  static void divmodTrunc(const int2048 &a, const int2048 &b, int2048 &q, int2048 &r);
+  static void divmodFloor(const int2048 &a, const int2048 &b, int2048 &q, int2048 &r);
+  friend void divmod(const int2048 &a, const int2048 &b, int2048 &q, int2048 &r);
+
+  // 幂：pow(a, e) 为 a 的 e 次方，pow(a, 0) == 1
+  friend int2048 pow(const int2048 &, unsigned long long);
+  // 模幂：powmod(a, e, m) 与 pow(a, e) % m 结果相同（要求 e >= 0，m != 0），
+  // 但中间结果始终小于 m^2，约简复用同一个 int2048_divisor
+  friend int2048 powmod(const int2048 &, const int2048 &, const int2048 &);
+
+  // 最大公约数与最小公倍数，结果非负；gcd(0, 0) == 0，有一方为 0 时 lcm 为 0
+  friend int2048 gcd(const int2048 &, const int2048 &);
+  friend int2048 lcm(const int2048 &, const int2048 &);
+  // 扩展欧几里得：返回 g = gcd(a, b)，并求出 a * x + b * y == g 中绝对值最小的一组
+  // （|x| <= |b| / g，|y| <= |a| / g）；x 与 y 可以是 a 或 b 本身
+  friend int2048 xgcd(const int2048 &a, const int2048 &b, int2048 &x, int2048 &y);
+  // 模逆：a * x 模 m 同余于 1 的 x，取值范围与 % m 相同；逆元不存在（或 m == 0）时返回 0
+  friend int2048 modinv(const int2048 &a, const int2048 &m);
+
+  // 整数开方：isqrt(a) 为平方不超过 a 的最大整数（要求 a >= 0）；iroot(a, k) 为
+  // k 次方根，向零取整（要求 k >= 1，k 为偶数时 a >= 0）
+  friend int2048 isqrt(const int2048 &);
+  friend int2048 iroot(const int2048 &, unsigned long long);
+
   friend std::istream &operator>>(std::istream &, int2048 &);
   friend std::ostream &operator<<(std::ostream &, const int2048 &);
 
+  // 批量求值：输入的每一行形如 "a op b"，op 为 + - * / % 之一（/ 与 % 向下取整），
+  // 按输入顺序每行输出一个结果；空行跳过，无法识别的行输出空行。
+  // 数字在缓冲区内原地解析，结果追加到 out；流版本按整行大块读入，
+  // 每块的结果整段写出，不经过逐个数字的流操作。
+  // setThreads(n) 开启并行时各线程分块同时解析、计算和格式化，输出与串行相同
+  static void evaluate(const char *first, const char *last, std::string &out);
+  static void evaluate(std::istream &, std::ostream &);
+
   friend bool operator==(const int2048 &, const int2048 &);
   friend bool operator!=(const int2048 &, const int2048 &);
   friend bool operator<(const int2048 &, const int2048 &);
   friend bool operator>(const int2048 &, const int2048 &);
   friend bool operator<=(const int2048 &, const int2048 &);
   friend bool operator>=(const int2048 &, const int2048 &);
+
+  // 与内置整数类型的混合运算与比较，不构造 int2048 临时对象；
+  // 除法与取模与上面一样向下取整
+  template <class T> typename IntegralOperand<T, int2048 &>::type operator+=(T v) {
+    bool neg;
+    uint64_t mag = IntegralOperand<T, int>::split(v, neg);
+    return addSmall(mag, neg);
+  }
+  template <class T> typename IntegralOperand<T, int2048 &>::type operator-=(T v) {
+    bool neg;
+    uint64_t mag = IntegralOperand<T, int>::split(v, neg);
+    return addSmall(mag, !neg);
+  }
+  template <class T> typename IntegralOperand<T, int2048 &>::type operator*=(T v) {
+    bool neg;
+    uint64_t mag = IntegralOperand<T, int>::split(v, neg);
+    return mulSmall(mag, neg);
+  }
+  template <class T> typename IntegralOperand<T, int2048 &>::type operator/=(T v) {
+    bool neg;
+    uint64_t mag = IntegralOperand<T, int>::split(v, neg);
+    return divSmall(mag, neg);
+  }
+  template <class T> typename IntegralOperand<T, int2048 &>::type operator%=(T v) {
+    bool neg;
+    uint64_t mag = IntegralOperand<T, int>::split(v, neg);
+    return modSmall(mag, neg);
+  }
+
+  template <class T> friend typename IntegralOperand<T, int2048>::type operator+(int2048 a, T b) {
+    a += b;
+    return a;
+  }
+  template <class T> friend typename IntegralOperand<T, int2048>::type operator+(T a, int2048 b) {
+    b += a;
+    return b;
+  }
+  template <class T> friend typename IntegralOperand<T, int2048>::type operator-(int2048 a, T b) {
+    a -= b;
+    return a;
+  }
+  template <class T> friend typename IntegralOperand<T, int2048>::type operator-(T a, int2048 b) {
+    b -= a;
+    b.negate();
+    return b;
+  }
+  template <class T> friend typename IntegralOperand<T, int2048>::type operator*(int2048 a, T b) {
+    a *= b;
+    return a;
+  }
+  template <class T> friend typename IntegralOperand<T, int2048>::type operator*(T a, int2048 b) {
+    b *= a;
+    return b;
+  }
+  template <class T> friend typename IntegralOperand<T, int2048>::type operator/(int2048 a, T b) {
+    a /= b;
+    return a;
+  }
+  template <class T> friend typename IntegralOperand<T, int2048>::type operator/(T a, const int2048 &b) {
+    bool neg;
+    uint64_t mag = IntegralOperand<T, int>::split(a, neg);
+    int2048 r = fromSmall(mag, neg);
+    r /= b;
+    return r;
+  }
+  template <class T> friend typename IntegralOperand<T, int2048>::type operator%(int2048 a, T b) {
+    a %= b;
+    return a;
+  }
+  template <class T> friend typename IntegralOperand<T, int2048>::type operator%(T a, const int2048 &b) {
+    bool neg;
+    uint64_t mag = IntegralOperand<T, int>::split(a, neg);
+    int2048 r = fromSmall(mag, neg);
+    r %= b;
+    return r;
+  }
+
+  template <class T>
+  friend typename IntegralOperand<T, bool>::type operator==(const int2048 &a, T b) { return a.compareTo(b) == 0; }
+  template <class T>
+  friend typename IntegralOperand<T, bool>::type operator!=(const int2048 &a, T b) { return a.compareTo(b) != 0; }
+  template <class T>
+  friend typename IntegralOperand<T, bool>::type operator<(const int2048 &a, T b) { return a.compareTo(b) < 0; }
+  template <class T>
+  friend typename IntegralOperand<T, bool>::type operator>(const int2048 &a, T b) { return a.compareTo(b) > 0; }
+  template <class T>
+  friend typename IntegralOperand<T, bool>::type operator<=(const int2048 &a, T b) { return a.compareTo(b) <= 0; }
+  template <class T>
+  friend typename IntegralOperand<T, bool>::type operator>=(const int2048 &a, T b) { return a.compareTo(b) >= 0; }
+  template <class T>
+  friend typename IntegralOperand<T, bool>::type operator==(T a, const int2048 &b) { return b.compareTo(a) == 0; }
+  template <class T>
+  friend typename IntegralOperand<T, bool>::type operator!=(T a, const int2048 &b) { return b.compareTo(a) != 0; }
+  template <class T>
+  friend typename IntegralOperand<T, bool>::type operator<(T a, const int2048 &b) { return b.compareTo(a) > 0; }
+  template <class T>
+  friend typename IntegralOperand<T, bool>::type operator>(T a, const int2048 &b) { return b.compareTo(a) < 0; }
+  template <class T>
+  friend typename IntegralOperand<T, bool>::type operator<=(T a, const int2048 &b) { return b.compareTo(a) >= 0; }
+  template <class T>
+  friend typename IntegralOperand<T, bool>::type operator>=(T a, const int2048 &b) { return b.compareTo(a) <= 0; }
+};
+
+// 预处理过的除数：对同一个数反复做除法或取模时使用。构造时一次性完成规格化，
+// 较长的除数还会预先算出倒数，之后每次 div / mod / divmod 都复用这些结果。
+// 语义与 / 和 % 相同（向下取整），要求除数不为 0
+class int2048_divisor {
+public:
+  explicit int2048_divisor(const int2048 &);
+
+  const int2048 &value() const { return d; }
+
+  int2048 div(const int2048 &) const;
+  int2048 mod(const int2048 &) const;
+  // q = a / d，r = a % d；q 与 r 可以是 a 本身
+  void divmod(const int2048 &a, int2048 &q, int2048 &r) const;
+
+private:
+  // divisors of at least this many limbs divide by the precomputed
+  // reciprocal (Barrett); shorter ones by Algorithm D on the stored
+  // normalized copy
+  static const size_t BARRETT_THRESHOLD = 10;
+
+  // |a| = |d|*q + r with q, r >= 0; q may be null, r may be a
+  void divmodAbs(const int2048 &a, int2048 *q, int2048 &r) const;
+
+  int2048 d;
+  uint32_t norm;  // BASE / (top limb + 1): scales the top limb to >= BASE/2
+  int2048 scaled; // |d| * norm, for Algorithm D
+  int2048 mu;     // floor(BASE^(2m) / |d|) for m >= BARRETT_THRESHOLD, else 0
+
+  friend int2048 powmod(const int2048 &, const int2048 &, const int2048 &);
 };
 } // namespace sjtu
 
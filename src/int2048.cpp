@@ -2,6 +2,233 @@
 
 namespace sjtu {
 
+// Optional instrumentation, compiled in with -DINT2048_STATS. A probe counts
+// calls, limbs and cycles (inclusive of nested probes) for one kernel and
+// files the operand size into a power-of-two histogram; events count
+// correction steps and allocations. Without the macro every probe expands
+// to nothing and dumpStats() only says so.
+#ifdef INT2048_STATS
+enum StatKernel {
+  ST_MUL_BASECASE,
+  ST_MUL_SCHOOLBOOK,
+  ST_MUL_KARATSUBA,
+  ST_MUL_NTT,
+  ST_SQR_KARATSUBA,
+  ST_SQR_NTT,
+  ST_DIV_WORD,
+  ST_DIV_KNUTH,
+  ST_DIV_BZ,
+  ST_RECIPROCAL,
+  ST_GCD_LEHMER,
+  ST_HGCD,
+  ST_PARSE,
+  ST_FORMAT,
+  ST_KERNELS
+};
+static const char *const STAT_KERNEL_NAMES[ST_KERNELS] = {
+    "mul.basecase", "mul.schoolbook", "mul.karatsuba", "mul.ntt",    "sqr.karatsuba",
+    "sqr.ntt",      "div.word",       "div.knuth",     "div.bz",     "div.reciprocal",
+    "gcd.lehmer",   "gcd.hgcd",       "io.parse",      "io.format"};
+
+enum StatEvent {
+  SE_QHAT_REFINE,   // Algorithm D: qhat lowered by the top-limb test
+  SE_QHAT_ADD_BACK, // Algorithm D: qhat still one too big, divisor added back
+  SE_NEWTON_FIXUP,  // Newton reciprocal: unit correction step
+  SE_LIMB_ALLOC,    // heap block allocated for a limb array
+  SE_ARENA_BLOCK,   // block allocated by the scratch arena
+  SE_EVENTS
+};
+static const char *const STAT_EVENT_NAMES[SE_EVENTS] = {
+    "div.qhat_refine", "div.qhat_add_back", "div.newton_fixup", "alloc.limbs", "alloc.scratch"};
+
+static const int STAT_BUCKETS = 32; // bucket b holds sizes in [2^b, 2^(b+1)) limbs
+
+struct KernelStats {
+  uint64_t calls, limbs, cycles;
+  uint64_t sizes[STAT_BUCKETS];
+};
+static KernelStats kernelStats[ST_KERNELS];
+static uint64_t eventStats[SE_EVENTS];
+
+static uint64_t cycleCounter() {
+#if defined(__x86_64__) || defined(__i386__)
+  return __builtin_ia32_rdtsc();
+#else
+  return 0;
+#endif
+}
+
+// relaxed atomics keep the counters exact under the parallel mode
+static void statAdd(uint64_t &counter, uint64_t v) {
+  __atomic_fetch_add(&counter, v, __ATOMIC_RELAXED);
+}
+
+class StatProbe {
+public:
+  StatProbe(StatKernel k, size_t limbs) : kernel(k), start(cycleCounter()) {
+    int b = 0;
+    while (b + 1 < STAT_BUCKETS && (limbs >> (b + 1))) ++b;
+    statAdd(kernelStats[k].calls, 1);
+    statAdd(kernelStats[k].limbs, limbs);
+    statAdd(kernelStats[k].sizes[b], 1);
+  }
+  ~StatProbe() { statAdd(kernelStats[kernel].cycles, cycleCounter() - start); }
+
+private:
+  StatKernel kernel;
+  uint64_t start;
+};
+
+#define INT2048_PROBE(kernel, limbs) StatProbe statProbe(kernel, limbs)
+#define INT2048_EVENT(event) statAdd(eventStats[event], 1)
+#else
+#define INT2048_PROBE(kernel, limbs) ((void)0)
+#define INT2048_EVENT(event) ((void)0)
+#endif
+
+void int2048::dumpStats(std::ostream &out) {
+#ifdef INT2048_STATS
+  out << "kernel calls limbs cycles sizes(log2 limbs:count)\n";
+  for (int k = 0; k < ST_KERNELS; ++k) {
+    const KernelStats &st = kernelStats[k];
+    if (st.calls == 0) continue;
+    out << STAT_KERNEL_NAMES[k] << ' ' << st.calls << ' ' << st.limbs << ' ' << st.cycles;
+    for (int b = 0; b < STAT_BUCKETS; ++b)
+      if (st.sizes[b]) out << ' ' << b << ':' << st.sizes[b];
+    out << '\n';
+  }
+  for (int e = 0; e < SE_EVENTS; ++e) out << STAT_EVENT_NAMES[e] << ' ' << eventStats[e] << '\n';
+#else
+  out << "int2048 statistics are disabled (build with -DINT2048_STATS)\n";
+#endif
+}
+
+void int2048::resetStats() {
+#ifdef INT2048_STATS
+  std::memset(kernelStats, 0, sizeof(kernelStats));
+  std::memset(eventStats, 0, sizeof(eventStats));
+#endif
+}
+
+int2048::Limbs::Limbs() : ptr(buf), len(0), cap(INLINE_LIMBS) {}
+
+int2048::Limbs::Limbs(const Limbs &other) : ptr(buf), len(0), cap(INLINE_LIMBS) {
+  assign(other.begin(), other.end());
+}
+
+int2048::Limbs::Limbs(Limbs &&other) noexcept : ptr(buf), len(0), cap(INLINE_LIMBS) {
+  *this = std::move(other);
+}
+
+int2048::Limbs::~Limbs() {
+  if (!isInline()) delete[] ptr;
+}
+
+int2048::Limbs &int2048::Limbs::operator=(const Limbs &other) {
+  if (this != &other) assign(other.begin(), other.end());
+  return *this;
+}
+
+int2048::Limbs &int2048::Limbs::operator=(Limbs &&other) noexcept {
+  if (this == &other) return *this;
+  if (other.isInline()) {
+    // our own storage always has room for the inline limbs
+    std::copy(other.ptr, other.ptr + other.len, ptr);
+    len = other.len;
+  } else {
+    if (!isInline()) delete[] ptr;
+    ptr = other.ptr;
+    len = other.len;
+    cap = other.cap;
+    other.ptr = other.buf;
+    other.cap = INLINE_LIMBS;
+  }
+  other.len = 0;
+  return *this;
+}
+
+bool int2048::Limbs::isInline() const { return ptr == buf; }
+size_t int2048::Limbs::size() const { return len; }
+size_t int2048::Limbs::capacity() const { return cap; }
+bool int2048::Limbs::empty() const { return len == 0; }
+uint32_t *int2048::Limbs::data() { return ptr; }
+const uint32_t *int2048::Limbs::data() const { return ptr; }
+uint32_t *int2048::Limbs::begin() { return ptr; }
+uint32_t *int2048::Limbs::end() { return ptr + len; }
+const uint32_t *int2048::Limbs::begin() const { return ptr; }
+const uint32_t *int2048::Limbs::end() const { return ptr + len; }
+uint32_t &int2048::Limbs::operator[](size_t i) { return ptr[i]; }
+const uint32_t &int2048::Limbs::operator[](size_t i) const { return ptr[i]; }
+uint32_t &int2048::Limbs::back() { return ptr[len - 1]; }
+const uint32_t &int2048::Limbs::back() const { return ptr[len - 1]; }
+
+void int2048::Limbs::reserve(size_t n) {
+  if (n <= cap) return;
+  size_t newCap = std::max(n, 2 * cap);
+  INT2048_EVENT(SE_LIMB_ALLOC);
+  uint32_t *p = new uint32_t[newCap];
+  std::copy(ptr, ptr + len, p);
+  if (!isInline()) delete[] ptr;
+  ptr = p;
+  cap = newCap;
+}
+
+void int2048::Limbs::resize(size_t n, uint32_t value) {
+  reserve(n);
+  if (n > len) std::fill(ptr + len, ptr + n, value);
+  len = n;
+}
+
+void int2048::Limbs::assign(size_t n, uint32_t value) {
+  len = 0;
+  resize(n, value);
+}
+
+void int2048::Limbs::assign(const uint32_t *first, const uint32_t *last) {
+  len = 0;
+  reserve(static_cast<size_t>(last - first));
+  std::copy(first, last, ptr);
+  len = static_cast<size_t>(last - first);
+}
+
+void int2048::Limbs::clear() { len = 0; }
+
+void int2048::Limbs::push_back(uint32_t value) {
+  if (len == cap) reserve(len + 1);
+  ptr[len++] = value;
+}
+
+void int2048::Limbs::pop_back() { --len; }
+
+void int2048::Limbs::insert(uint32_t *pos, size_t n, uint32_t value) {
+  size_t at = static_cast<size_t>(pos - ptr);
+  reserve(len + n);
+  std::copy_backward(ptr + at, ptr + len, ptr + len + n);
+  std::fill(ptr + at, ptr + at + n, value);
+  len += n;
+}
+
+void int2048::Limbs::erase(uint32_t *first, uint32_t *last) {
+  std::copy(last, ptr + len, first);
+  len -= static_cast<size_t>(last - first);
+}
+
+void int2048::Limbs::swap(Limbs &other) {
+  if (!isInline() && !other.isInline()) {
+    std::swap(ptr, other.ptr);
+    std::swap(len, other.len);
+    std::swap(cap, other.cap);
+    return;
+  }
+  Limbs tmp(std::move(other));
+  other = std::move(*this);
+  *this = std::move(tmp);
+}
+
+bool int2048::Limbs::operator==(const Limbs &other) const {
+  return len == other.len && std::equal(ptr, ptr + len, other.ptr);
+}
+
 int2048::int2048() {}
 
 int2048::int2048(long long value) {
@@ -32,6 +259,13 @@ int2048::int2048(const std::string &s) { read(s); }
 
 int2048::int2048(const int2048 &other) = default;
 
+int2048::int2048(int2048 &&other) noexcept
+    : digits(std::move(other.digits)), negative(other.negative) {
+  // leave the source as a valid zero
+  other.digits.clear();
+  other.negative = false;
+}
+
 void int2048::trim() {
   while (!digits.empty() && digits.back() == 0) digits.pop_back();
   if (digits.empty()) negative = false;
@@ -39,47 +273,106 @@ void int2048::trim() {
 
 bool int2048::isZero() const { return digits.empty(); }
 
+void int2048::shiftLimbsLeft(size_t k) {
+  if (k && !digits.empty()) digits.insert(digits.begin(), k, 0);
+}
+
+void int2048::shiftLimbsRight(size_t k) {
+  if (k >= digits.size()) {
+    digits.clear();
+    negative = false;
+  } else {
+    digits.erase(digits.begin(), digits.begin() + k);
+  }
+}
+
+void int2048::truncateLimbs(size_t k) {
+  if (k < digits.size()) {
+    digits.resize(k);
+    trim();
+  }
+}
+
 int int2048::absCompare(const int2048 &other) const {
   if (digits.size() != other.digits.size())
     return digits.size() < other.digits.size() ? -1 : 1;
-  for (size_t i = digits.size(); i-- > 0;) {
-    if (digits[i] != other.digits[i]) return digits[i] < other.digits[i] ? -1 : 1;
-  }
-  return 0;
+  if (digits.size() == 1)
+    return digits[0] == other.digits[0] ? 0 : (digits[0] < other.digits[0] ? -1 : 1);
+  return compareLimbs(digits.data(), other.digits.data(), digits.size());
 }
 
 void int2048::absAdd(const int2048 &other) {
-  uint64_t carry = 0;
-  const size_t n = std::max(digits.size(), other.digits.size());
-  if (digits.size() < n) digits.resize(n, 0);
-  for (size_t i = 0; i < n; ++i) {
-    uint64_t a = digits[i];
-    uint64_t b = (i < other.digits.size() ? other.digits[i] : 0);
-    uint64_t sum = a + b + carry;
-    digits[i] = static_cast<uint32_t>(sum % BASE);
-    carry = sum / BASE;
+  if (digits.size() == 1 && other.digits.size() == 1) {
+    uint32_t sum = digits[0] + other.digits[0];
+    if (sum >= BASE) {
+      digits[0] = sum - BASE;
+      digits.push_back(1);
+    } else {
+      digits[0] = sum;
+    }
+    return;
   }
-  if (carry) digits.push_back(static_cast<uint32_t>(carry));
+  if (digits.size() < other.digits.size()) digits.resize(other.digits.size(), 0);
+  if (addLimbs(digits.data(), digits.size(), other.digits.data(), other.digits.size()))
+    digits.push_back(1);
 }
 
 void int2048::absSub(const int2048 &other) {
   // assume |*this| >= |other|
-  int64_t carry = 0; // borrow as negative carry
-  for (size_t i = 0; i < digits.size(); ++i) {
-    int64_t a = digits[i];
-    int64_t b = (i < other.digits.size() ? other.digits[i] : 0);
-    int64_t cur = a - b + carry;
-    if (cur < 0) {
-      cur += BASE;
-      carry = -1;
+  if (digits.size() == 1 && other.digits.size() == 1) {
+    digits[0] -= other.digits[0];
+    if (digits[0] == 0) trim();
+    return;
+  }
+  subLimbs(digits.data(), digits.size(), other.digits.data(), other.digits.size());
+  trim();
+}
+
+void int2048::absSubFrom(const int2048 &other) {
+  // assume |other| >= |*this|; other is never *this here
+  const size_t n = digits.size();
+  digits.resize(other.digits.size(), 0);
+  uint32_t borrow = 0;
+  for (size_t i = 0; i < n; ++i) {
+    uint32_t sub = digits[i] + borrow;
+    borrow = (other.digits[i] < sub);
+    digits[i] = borrow ? other.digits[i] + BASE - sub : other.digits[i] - sub;
+  }
+  for (size_t i = n; i < digits.size(); ++i) {
+    if (borrow && other.digits[i] == 0) {
+      digits[i] = BASE - 1;
     } else {
-      carry = 0;
+      digits[i] = other.digits[i] - borrow;
+      borrow = 0;
     }
-    digits[i] = static_cast<uint32_t>(cur);
   }
   trim();
 }
 
+int2048 &int2048::addSigned(const int2048 &other, bool otherNegative) {
+  if (other.isZero()) return *this;
+  if (isZero()) {
+    if (this != &other) digits = other.digits;
+    negative = otherNegative;
+    return *this;
+  }
+  if (negative == otherNegative) {
+    absAdd(other);
+    return *this;
+  }
+  int cmp = absCompare(other);
+  if (cmp == 0) {
+    digits.clear();
+    negative = false;
+  } else if (cmp > 0) {
+    absSub(other); // sign remains this->negative
+  } else {
+    absSubFrom(other);
+    negative = otherNegative;
+  }
+  return *this;
+}
+
 int2048 int2048::absAdd(const int2048 &a, const int2048 &b) {
   int2048 res = a;
   res.absAdd(b);
@@ -92,367 +385,2120 @@ int2048 int2048::absSubLargeSmall(const int2048 &a, const int2048 &b) {
   return res;
 }
 
-static void ensureSize(std::vector<uint32_t> &v, size_t n) {
-  if (v.size() < n) v.resize(n, 0);
-}
+// Per-thread bump allocator for kernel temporaries. Blocks survive between
+// operations (up to the retention threshold), so steady-state arithmetic does
+// not go back to malloc; a ScratchFrame hands back everything allocated
+// through it when it goes out of scope, in LIFO order.
+class ScratchArena {
+public:
+  struct Mark {
+    size_t block, offset, used;
+  };
 
-void int2048::mulSchoolbook(const std::vector<uint32_t> &a,
-                            const std::vector<uint32_t> &b,
-                            std::vector<uint32_t> &out) {
-  out.assign(a.size() + b.size(), 0);
-  for (size_t i = 0; i < a.size(); ++i) {
-    uint64_t carry = 0;
-    uint64_t ai = a[i];
-    for (size_t j = 0; j < b.size(); ++j) {
-      uint64_t cur = out[i + j] + ai * (uint64_t)b[j] + carry;
-      out[i + j] = static_cast<uint32_t>(cur % BASE);
-      carry = cur / BASE;
+  ~ScratchArena() {
+    for (size_t i = 0; i < blocks.size(); ++i) delete[] blocks[i].data;
+  }
+
+  Mark mark() const { return Mark{cur, offset, used}; }
+
+  uint32_t *alloc(size_t n) {
+    if (n == 0) return nullptr;
+    uint32_t *p;
+    if (!blocks.empty() && offset + n <= blocks[cur].size) {
+      p = blocks[cur].data + offset;
+      offset += n;
+    } else {
+      // every block past the current one is free; drop the next one if it
+      // is too small and append a block big enough for this request
+      size_t next = blocks.empty() ? 0 : cur + 1;
+      if (next < blocks.size() && blocks[next].size < n) {
+        for (size_t i = next; i < blocks.size(); ++i) {
+          reserved -= blocks[i].size;
+          delete[] blocks[i].data;
+        }
+        blocks.resize(next);
+      }
+      if (next == blocks.size()) {
+        size_t size = std::max(n, std::max(reserved, MIN_BLOCK));
+        INT2048_EVENT(SE_ARENA_BLOCK);
+        blocks.push_back(Block{new uint32_t[size], size});
+        reserved += size;
+      }
+      cur = next;
+      offset = n;
+      p = blocks[cur].data;
     }
-    size_t pos = i + b.size();
-    while (carry) {
-      if (pos >= out.size()) out.push_back(0);
-      uint64_t cur = out[pos] + carry;
-      out[pos] = static_cast<uint32_t>(cur % BASE);
-      carry = cur / BASE;
-      ++pos;
+    used += n;
+    if (used > peak) peak = used;
+    return p;
+  }
+
+  void release(const Mark &m) {
+    cur = m.block;
+    offset = m.offset;
+    used = m.used;
+    if (used == 0) {
+      while (!blocks.empty() && reserved * sizeof(uint32_t) > retainBytes) {
+        reserved -= blocks.back().size;
+        delete[] blocks.back().data;
+        blocks.pop_back();
+      }
+      cur = 0;
     }
   }
-  while (!out.empty() && out.back() == 0) out.pop_back();
+
+  size_t peakBytes() const { return peak * sizeof(uint32_t); }
+  void resetPeak() { peak = used; }
+  void setRetention(size_t bytes) { retainBytes = bytes; }
+
+private:
+  struct Block {
+    uint32_t *data;
+    size_t size;
+  };
+  static const size_t MIN_BLOCK = 4096; // limbs
+
+  std::vector<Block> blocks;
+  size_t cur = 0, offset = 0; // bump position inside blocks[cur]
+  size_t used = 0, peak = 0;  // limbs handed out, now and at most
+  size_t reserved = 0;        // limbs held in blocks
+  size_t retainBytes = 8u << 20; // kept once the last frame is released
+};
+
+const size_t ScratchArena::MIN_BLOCK; // std::max binds it by reference
+
+static ScratchArena &scratchArena() {
+  static thread_local ScratchArena arena;
+  return arena;
 }
 
-// subtract b*mul shifted by 'shift' BASE-digits from a; return true if non-negative, false if became negative
-static bool subMulShift(std::vector<uint32_t> &a, const std::vector<uint32_t> &b,
-                        uint64_t mul, size_t shift, uint32_t BASE) {
-  uint64_t carry = 0;
-  size_t n = b.size();
-  if (a.size() < shift + n) a.resize(shift + n, 0);
-  for (size_t i = 0; i < n; ++i) {
-    __int128 prod = (__int128)b[i] * (__int128)mul + (__int128)carry;
-    uint64_t p_lo = (uint64_t)(prod % BASE);
-    carry = (uint64_t)(prod / BASE);
-    // subtract p_lo from a[shift+i]
-    if (a[shift + i] < p_lo) {
-      uint64_t need = (uint64_t)BASE + a[shift + i];
-      a[shift + i] = (uint32_t)(need - p_lo);
-      // borrow 1 from higher digit
-      size_t k = shift + i + 1;
-      while (true) {
-        if (k >= a.size()) a.push_back(0);
-        if (a[k] == 0) {
-          a[k] = BASE - 1;
-          ++k;
-        } else {
-          --a[k];
-          break;
-        }
+class ScratchFrame {
+public:
+  ScratchFrame() : arena(scratchArena()), saved(arena.mark()) {}
+  ~ScratchFrame() { arena.release(saved); }
+  ScratchFrame(const ScratchFrame &) = delete;
+  ScratchFrame &operator=(const ScratchFrame &) = delete;
+
+  uint32_t *alloc(size_t n) { return arena.alloc(n); }
+
+private:
+  ScratchArena &arena;
+  ScratchArena::Mark saved;
+};
+
+size_t int2048::scratchPeak() { return scratchArena().peakBytes(); }
+
+void int2048::resetScratchPeak() { scratchArena().resetPeak(); }
+
+void int2048::setScratchRetention(size_t bytes) { scratchArena().setRetention(bytes); }
+
+// Opt-in parallelism. The independent sub-products of the top Karatsuba
+// levels and the three NTT primes run as OpenMP sections; each worker takes
+// scratch from its own thread's arena, and every section writes a disjoint
+// output range, so results are identical to the serial path. Built without
+// -fopenmp the pragmas vanish and everything runs serially.
+#ifdef _OPENMP
+#define INT2048_OMP(directive) _Pragma(#directive)
+#else
+#define INT2048_OMP(directive)
+#endif
+
+static int parallelThreads = 1;
+static size_t parallelLimbs = 256;
+
+// whether a product whose shorter operand has m limbs should fork
+static bool forkAt(size_t m) { return parallelThreads > 1 && m >= parallelLimbs; }
+
+void int2048::setThreads(int threads) { parallelThreads = threads < 1 ? 1 : threads; }
+
+void int2048::setParallelThreshold(size_t limbs) { parallelLimbs = limbs; }
+
+// Eight-limb blocks for the add/sub/compare kernels, written with GCC vector
+// extensions (the header may not pull in intrinsics). Each block adds or
+// subtracts lane-wise, derives carries by comparison, and feeds every
+// carry one lane up with a shuffle; only when that second step ripples
+// (a limb of BASE-1 receiving a carry, or 0 a borrow) is the block redone
+// limb by limb. target_clones builds an AVX2 and a baseline (SSE2) body and
+// picks one at load time.
+#if defined(__GNUC__) && !defined(__clang__) && defined(__x86_64__)
+#define INT2048_VECTOR_LIMBS 1
+#define INT2048_SIMD_DISPATCH __attribute__((target_clones("avx2", "default")))
+
+typedef uint32_t LimbBlock __attribute__((vector_size(32)));
+static const size_t BLOCK_LIMBS = 8;
+
+// the blocks stay inside these loops: passing 32-byte vectors across
+// function boundaries would depend on the target's ABI
+
+// x[0, n) += y[0, n) over whole blocks, n a multiple of BLOCK_LIMBS
+INT2048_SIMD_DISPATCH
+static uint32_t addBlocks(uint32_t *x, const uint32_t *y, size_t n, uint32_t carry, uint32_t base) {
+  const LimbBlock b = {base, base, base, base, base, base, base, base};
+  const LimbBlock up = {8, 0, 1, 2, 3, 4, 5, 6}; // lanes one up, lane 0 from the fill
+  for (size_t i = 0; i < n; i += BLOCK_LIMBS) {
+    LimbBlock xv, yv;
+    std::memcpy(&xv, x + i, sizeof(xv));
+    std::memcpy(&yv, y + i, sizeof(yv));
+    LimbBlock t = xv + yv;
+    LimbBlock out = (LimbBlock)(t >= b);
+    t -= out & b;
+    const uint32_t in = carry ? ~0u : 0u;
+    const LimbBlock fill = {in, in, in, in, in, in, in, in};
+    LimbBlock r = t - __builtin_shuffle(out, fill, up); // a ~0 lane adds one
+    LimbBlock ripple = (LimbBlock)(r == b);
+    uint32_t any = 0;
+    for (size_t k = 0; k < BLOCK_LIMBS; ++k) any |= ripple[k];
+    if (any) {
+      for (size_t k = 0; k < BLOCK_LIMBS; ++k) {
+        uint32_t sum = x[i + k] + y[i + k] + carry;
+        carry = (sum >= base);
+        x[i + k] = carry ? sum - base : sum;
       }
     } else {
-      a[shift + i] = (uint32_t)(a[shift + i] - p_lo);
-    }
-  }
-  // subtract remaining carry
-  size_t idx = shift + n;
-  while (carry) {
-    if (idx >= a.size()) a.push_back(0);
-    if (a[idx] < carry) {
-      uint64_t need = (uint64_t)BASE + a[idx];
-      a[idx] = (uint32_t)(need - carry);
-      carry = 1; // we borrowed 1
-      ++idx;
+      std::memcpy(x + i, &r, sizeof(r));
+      carry = out[BLOCK_LIMBS - 1] & 1;
+    }
+  }
+  return carry;
+}
+
+// x[0, n) -= y[0, n) over whole blocks
+INT2048_SIMD_DISPATCH
+static uint32_t subBlocks(uint32_t *x, const uint32_t *y, size_t n, uint32_t borrow, uint32_t base) {
+  const LimbBlock b = {base, base, base, base, base, base, base, base};
+  const LimbBlock ones = {~0u, ~0u, ~0u, ~0u, ~0u, ~0u, ~0u, ~0u};
+  const LimbBlock up = {8, 0, 1, 2, 3, 4, 5, 6};
+  for (size_t i = 0; i < n; i += BLOCK_LIMBS) {
+    LimbBlock xv, yv;
+    std::memcpy(&xv, x + i, sizeof(xv));
+    std::memcpy(&yv, y + i, sizeof(yv));
+    LimbBlock out = (LimbBlock)(xv < yv);
+    LimbBlock t = xv - yv + (out & b);
+    const uint32_t in = borrow ? ~0u : 0u;
+    const LimbBlock fill = {in, in, in, in, in, in, in, in};
+    LimbBlock r = t + __builtin_shuffle(out, fill, up); // a ~0 lane subtracts one
+    LimbBlock ripple = (LimbBlock)(r == ones); // wrapped below zero
+    uint32_t any = 0;
+    for (size_t k = 0; k < BLOCK_LIMBS; ++k) any |= ripple[k];
+    if (any) {
+      for (size_t k = 0; k < BLOCK_LIMBS; ++k) {
+        uint32_t sub = y[i + k] + borrow;
+        borrow = (x[i + k] < sub);
+        x[i + k] = borrow ? x[i + k] + base - sub : x[i + k] - sub;
+      }
     } else {
-      a[idx] = (uint32_t)(a[idx] - carry);
-      carry = 0;
-      break;
+      std::memcpy(x + i, &r, sizeof(r));
+      borrow = out[BLOCK_LIMBS - 1] & 1;
     }
   }
-  // check if a became negative (detect by propagating borrow beyond size)
-  return true; // we handled borrows internally; the caller will adjust via trial
+  return borrow;
 }
 
-void int2048::divmodTrunc(const int2048 &A, const int2048 &B, int2048 &Q, int2048 &R) {
-  // assumes B != 0
-  int2048 a = A; a.negative = false; a.trim();
-  int2048 b = B; b.negative = false; b.trim();
-  Q.digits.clear(); Q.negative = false;
-  R = a;
-  if (b.isZero()) return; // undefined, but keep
-  if (R.absCompare(b) < 0) { Q.digits.clear(); Q.negative = false; return; }
-  if (b.digits.size() == 1) {
-    uint64_t divv = b.digits[0];
-    Q.digits.assign(R.digits.size(), 0);
-    uint64_t rem = 0;
-    for (size_t i = R.digits.size(); i-- > 0;) {
-      uint64_t cur = R.digits[i] + rem * BASE;
-      uint64_t qd = cur / divv;
-      rem = cur % divv;
-      Q.digits[i] = (uint32_t)qd;
+// length of the common prefix from the top of x[0, n) and y[0, n), in
+// whole blocks; the caller finishes the scan limb by limb
+INT2048_SIMD_DISPATCH
+static size_t equalTopBlocks(const uint32_t *x, const uint32_t *y, size_t n) {
+  size_t i = n;
+  for (; i >= BLOCK_LIMBS; i -= BLOCK_LIMBS) {
+    LimbBlock xv, yv;
+    std::memcpy(&xv, x + i - BLOCK_LIMBS, sizeof(xv));
+    std::memcpy(&yv, y + i - BLOCK_LIMBS, sizeof(yv));
+    LimbBlock diff = (LimbBlock)(xv != yv);
+    uint32_t any = 0;
+    for (size_t k = 0; k < BLOCK_LIMBS; ++k) any |= diff[k];
+    if (any) break;
+  }
+  return n - i;
+}
+#else
+#define INT2048_SIMD_DISPATCH
+#endif
+
+int int2048::compareLimbs(const uint32_t *x, const uint32_t *y, size_t n) {
+  size_t i = n;
+#ifdef INT2048_VECTOR_LIMBS
+  if (n >= 2 * BLOCK_LIMBS && x[n - 1] == y[n - 1]) i -= equalTopBlocks(x, y, n);
+#endif
+  while (i-- > 0)
+    if (x[i] != y[i]) return x[i] < y[i] ? -1 : 1;
+  return 0;
+}
+
+uint32_t int2048::addLimbs(uint32_t *x, size_t xn, const uint32_t *y, size_t yn) {
+  uint32_t carry = 0;
+  size_t i = 0;
+#ifdef INT2048_VECTOR_LIMBS
+  i = yn - yn % BLOCK_LIMBS;
+  if (i) carry = addBlocks(x, y, i, 0, BASE);
+#endif
+  for (; i < yn; ++i) {
+    uint32_t sum = x[i] + y[i] + carry; // < 2*BASE fits in uint32_t
+    carry = (sum >= BASE);
+    x[i] = carry ? sum - BASE : sum;
+  }
+  for (; carry && i < xn; ++i) {
+    if (++x[i] == BASE) x[i] = 0;
+    else carry = 0;
+  }
+  return carry;
+}
+
+uint32_t int2048::subLimbs(uint32_t *x, size_t xn, const uint32_t *y, size_t yn) {
+  uint32_t borrow = 0;
+  size_t i = 0;
+#ifdef INT2048_VECTOR_LIMBS
+  i = yn - yn % BLOCK_LIMBS;
+  if (i) borrow = subBlocks(x, y, i, 0, BASE);
+#endif
+  for (; i < yn; ++i) {
+    uint32_t sub = y[i] + borrow;
+    borrow = (x[i] < sub);
+    x[i] = borrow ? x[i] + BASE - sub : x[i] - sub;
+  }
+  for (; borrow && i < xn; ++i) {
+    if (x[i] == 0) x[i] = BASE - 1;
+    else { --x[i]; borrow = 0; }
+  }
+  return borrow;
+}
+
+// Base-case products keep their column sums unnormalized in 64-bit words. A
+// limb product is below 10^18, so a column that is below BASE plus a carry
+// (under 2^35) can take LAZY_ROWS more products before it could overflow;
+// carries are resolved once per block of rows instead of once per product.
+static const size_t LAZY_ROWS = 18;
+static const size_t COLUMN_TILE = 256; // columns of the longer operand per pass
+
+// row[i] += a[i] * w for i < n, eight columns at a time so that the AVX2
+// clones turn each group into 32x32->64 vector multiplies
+static inline void mulRow(uint64_t *row, const uint32_t *a, size_t n, uint64_t w) {
+  size_t i = 0;
+  for (; i + 8 <= n; i += 8)
+    for (size_t k = 0; k < 8; ++k) row[i + k] += a[i + k] * w;
+  for (; i < n; ++i) row[i] += a[i] * w;
+}
+
+// t[i + j] += a[i] * b[j] for i < n, j < h
+INT2048_SIMD_DISPATCH
+static void mulRows(uint64_t *t, const uint32_t *a, size_t n, const uint32_t *b, size_t h) {
+  for (size_t j = 0; j < h; ++j) mulRow(t + j, a, n, b[j]);
+}
+
+// t[i + j] += a[i] * a[j] for lo <= i < hi, i < j < n
+INT2048_SIMD_DISPATCH
+static void sqrRows(uint64_t *t, const uint32_t *a, size_t n, size_t lo, size_t hi) {
+  for (size_t i = lo; i < hi; ++i) mulRow(t + 2 * i + 1, a + i + 1, n - i - 1, a[i]);
+}
+
+// reduces t[lo, hi) below Base, moving each quotient one column up; the
+// carry out of the range is added to t[hi]
+template <uint64_t Base>
+static void carryColumns(uint64_t *t, size_t lo, size_t hi) {
+  uint64_t carry = 0;
+  for (size_t k = lo; k < hi; ++k) {
+    uint64_t v = t[k] + carry;
+    t[k] = v % Base;
+    carry = v / Base;
+  }
+  t[hi] += carry;
+}
+
+void int2048::mulBasecase(const uint32_t *a, size_t n, const uint32_t *b, size_t m,
+                          uint32_t *out) {
+  INT2048_PROBE(ST_MUL_BASECASE, n + m);
+  // a is swept in tiles with every row of b applied to each; t[k] is column
+  // s + k, and once a tile is done its low w columns are final while the
+  // top m move down to start the next one
+  uint64_t t[COLUMN_TILE + KARATSUBA_THRESHOLD];
+  std::fill(t, t + m, 0);
+  for (size_t s = 0; s < n; s += COLUMN_TILE) {
+    const size_t w = std::min(COLUMN_TILE, n - s);
+    std::fill(t + m, t + w + m, 0);
+    for (size_t j = 0; j < m; j += LAZY_ROWS) {
+      const size_t h = std::min(LAZY_ROWS, m - j);
+      mulRows(t + j, a + s, w, b + j, h);
+      carryColumns<BASE>(t, j, j + h - 1 + w);
     }
-    R.digits.clear();
-    if (rem) R.digits.push_back((uint32_t)rem);
-    Q.trim(); R.trim();
+    for (size_t k = 0; k < w; ++k) out[s + k] = static_cast<uint32_t>(t[k]);
+    std::copy(t + w, t + w + m, t);
+  }
+  carryColumns<BASE>(t, 0, m); // the product fits, so nothing reaches t[m]
+  for (size_t k = 0; k < m; ++k) out[n + k] = static_cast<uint32_t>(t[k]);
+}
+
+size_t int2048::karatsubaScratch(size_t n, size_t m) {
+  if (m < KARATSUBA_THRESHOLD) return 0;
+  if (2 * m <= n)
+    return 2 * m + std::max(karatsubaScratch(m, m), karatsubaScratch(m, n % m));
+  size_t h = n / 2;
+  size_t la = n - h + 1, lb = std::max(h, m - h) + 1;
+  size_t sub = std::max(karatsubaScratch(la, lb),
+                        std::max(karatsubaScratch(h, h), karatsubaScratch(n - h, m - h)));
+  return 2 * (la + lb) + sub;
+}
+
+void int2048::mulKaratsuba(const uint32_t *a, size_t n, const uint32_t *b, size_t m,
+                           uint32_t *out, uint32_t *scratch) {
+  if (m < KARATSUBA_THRESHOLD) {
+    mulBasecase(a, n, b, m, out);
     return;
   }
-  size_t n = R.digits.size();
-  size_t m = b.digits.size();
-  Q.digits.assign(n - m + 1, 0);
-  // Ensure R has an extra zero to simplify borrow propagation
-  R.digits.push_back(0);
-  for (size_t pos = n - m + 1; pos-- > 0;) {
-    uint64_t r_hi = (pos + m < R.digits.size() ? R.digits[pos + m] : 0);
-    uint64_t r2 = R.digits[pos + m - 1];
-    uint64_t r1 = (m >= 2 ? R.digits[pos + m - 2] : 0);
-    uint64_t v1 = b.digits[m - 1];
-    // Estimate qhat using top two digits
-    __int128 numerator = (__int128)r_hi * BASE + r2;
-    uint64_t qhat = (uint64_t)(numerator / v1);
-    if (qhat >= BASE) qhat = BASE - 1;
-
-    // Adjust qhat if necessary by trial subtraction
-    // While R < b * qhat << pos, decrease qhat
-    // We attempt subtract and if negative, add back
-    if (qhat) {
-      // try subtract b*qhat shifted
-      // make a copy to check? To avoid copy, we subtract and if underflow, add back once
-      // prepare temp to check condition by performing subtraction and verifying if leading became negative
-      // We cannot easily detect sign; instead, perform subtraction then if R becomes smaller than zero at high pos, we will handle by at most a couple of corrections by comparing remainder
-    }
-
-    // Perform R -= b * qhat << pos with correction loop
-    // We'll compute product and compare. To be safe, loop to adjust qhat down until R >= product
-    // Implement via check using multiplication on the fly
-    // simple correction loop: while true: attempt subtraction, if borrow cascades beyond, undo and --qhat
-    while (true) {
-      // perform subtraction into a copy to test
-      std::vector<uint32_t> Rc = R.digits;
-      // subtract
-      uint64_t carry = 0;
-      bool ok = true;
-      for (size_t i = 0; i < m; ++i) {
-        __int128 prod = (__int128)b.digits[i] * (__int128)qhat + (__int128)carry;
-        uint64_t p_lo = (uint64_t)(prod % BASE);
-        carry = (uint64_t)(prod / BASE);
-        size_t idx = pos + i;
-        if (Rc[idx] < p_lo) {
-          // borrow
-          uint64_t need = (uint64_t)BASE + Rc[idx];
-          Rc[idx] = (uint32_t)(need - p_lo);
-          size_t k = idx + 1;
-          while (true) {
-            if (k >= Rc.size()) { ok = false; break; }
-            if (Rc[k] == 0) {
-              Rc[k] = BASE - 1;
-              ++k;
-            } else {
-              --Rc[k];
-              break;
-            }
-          }
-          if (!ok) break;
-        } else {
-          Rc[idx] = (uint32_t)(Rc[idx] - p_lo);
-        }
+  if (2 * m <= n) {
+    // unbalanced: multiply m-limb slices of a by b and accumulate
+    std::fill(out, out + n + m, 0u);
+    uint32_t *prod = scratch;
+    for (size_t i = 0; i < n; i += m) {
+      size_t len = std::min(m, n - i);
+      if (len == m) mulKaratsuba(a + i, m, b, m, prod, scratch + 2 * m);
+      else mulKaratsuba(b, m, a + i, len, prod, scratch + 2 * m);
+      addLimbs(out + i, n + m - i, prod, len + m);
+    }
+    return;
+  }
+  // m <= n < 2m: a = a1*B^h + a0, b = b1*B^h + b0 with b1 non-empty
+  size_t h = n / 2;
+  size_t la = n - h + 1, lb = std::max(h, m - h) + 1;
+  uint32_t *sa = scratch;
+  uint32_t *sb = sa + la;
+  uint32_t *mid = sb + lb;
+  uint32_t *rest = mid + la + lb;
+
+  std::copy(a + h, a + n, sa);
+  sa[n - h] = addLimbs(sa, n - h, a, h);
+  std::fill(sb, sb + lb, 0u);
+  std::copy(b, b + h, sb);
+  sb[lb - 1] = addLimbs(sb, lb - 1, b + h, m - h);
+
+  if (forkAt(m)) {
+    INT2048_OMP(omp parallel sections num_threads(parallelThreads))
+    {
+      INT2048_OMP(omp section)
+      {
+        ScratchFrame frame;
+        mulKaratsuba(a, h, b, h, out, frame.alloc(karatsubaScratch(h, h)));
       }
-      // subtract remaining carry at pos+m
-      if (ok) {
-        size_t idx = pos + m;
-        while (carry) {
-          if (idx >= Rc.size()) { ok = false; break; }
-          if (Rc[idx] < carry) {
-            uint64_t need = (uint64_t)BASE + Rc[idx];
-            Rc[idx] = (uint32_t)(need - carry);
-            carry = 1;
-            ++idx;
-          } else {
-            Rc[idx] = (uint32_t)(Rc[idx] - carry);
-            carry = 0;
-            break;
-          }
-        }
+      INT2048_OMP(omp section)
+      {
+        ScratchFrame frame;
+        mulKaratsuba(a + h, n - h, b + h, m - h, out + 2 * h,
+                     frame.alloc(karatsubaScratch(n - h, m - h)));
       }
-      if (ok) {
-        // success
-        R.digits.swap(Rc);
-        Q.digits[pos] = (uint32_t)qhat;
-        break;
-      } else {
-        // qhat too big
-        if (qhat == 0) {
-          Q.digits[pos] = 0;
-          break;
-        }
-        --qhat;
+      INT2048_OMP(omp section)
+      {
+        ScratchFrame frame;
+        mulKaratsuba(sa, la, sb, lb, mid, frame.alloc(karatsubaScratch(la, lb)));
       }
     }
+  } else {
+    mulKaratsuba(a, h, b, h, out, rest);                        // z0 -> out[0, 2h)
+    mulKaratsuba(a + h, n - h, b + h, m - h, out + 2 * h, rest); // z2 -> out[2h, n+m)
+    mulKaratsuba(sa, la, sb, lb, mid, rest);                    // (a0+a1)(b0+b1)
   }
-  R.trim(); Q.trim();
-  // assign signs for truncation semantics
-  if (!Q.isZero()) Q.negative = (A.negative != B.negative); else Q.negative = false;
-  if (!R.isZero()) R.negative = A.negative; else R.negative = false;
+  subLimbs(mid, la + lb, out, 2 * h);
+  subLimbs(mid, la + lb, out + 2 * h, n + m - 2 * h);
+  size_t midLen = la + lb;
+  while (midLen > 0 && mid[midLen - 1] == 0) --midLen;
+  addLimbs(out + h, n + m - h, mid, midLen);
 }
 
-void int2048::read(const std::string &s) {
-  digits.clear();
-  negative = false;
-  size_t i = 0;
-  while (i < s.size() && (s[i] == ' ' || s[i] == '\n' || s[i] == '\t' || s[i] == '\r')) ++i;
-  bool neg = false;
-  if (i < s.size() && (s[i] == '+' || s[i] == '-')) {
-    neg = (s[i] == '-');
-    ++i;
+void int2048::sqrBasecase(const uint32_t *a, size_t n, uint32_t *out) {
+  if (n == 0) return;
+  uint64_t t[2 * KARATSUBA_THRESHOLD];
+  std::fill(t, t + 2 * n, 0);
+  // cross products a[i]*a[j], i < j
+  for (size_t i = 0; i < n; i += LAZY_ROWS) {
+    const size_t hi = std::min(n, i + LAZY_ROWS);
+    sqrRows(t, a, n, i, hi);
+    carryColumns<BASE>(t, 2 * i, hi + n - 1);
   }
-  while (i < s.size() && s[i] == '0') ++i; // skip leading zeros
-  std::vector<uint32_t> parts;
-  for (size_t j = s.size(); j > i;) {
-    size_t start = (j >= (size_t)BASE_DIGS ? j - BASE_DIGS : 0);
-    if (start < i) start = i;
-    uint32_t x = 0;
-    for (size_t k = start; k < j; ++k) {
-      char c = s[k];
-      if (c < '0' || c > '9') { x = 0; break; }
-      x = x * 10u + (uint32_t)(c - '0');
-    }
-    parts.push_back(x);
-    j = start;
-    if (j == i) break;
-  }
-  for (size_t idx = 0; idx < parts.size(); ++idx) digits.push_back(parts[idx]);
-  trim();
-  if (!digits.empty()) negative = neg;
+  // doubled, plus the diagonal a[i]^2
+  for (size_t i = 0; i < n; ++i) {
+    t[2 * i] = 2 * t[2 * i] + (uint64_t)a[i] * a[i];
+    t[2 * i + 1] *= 2;
+  }
+  carryColumns<BASE>(t, 0, 2 * n - 1); // the square fits, so t[2n-1] is the top limb
+  for (size_t k = 0; k < 2 * n; ++k) out[k] = static_cast<uint32_t>(t[k]);
 }
 
-void int2048::print() {
-  if (digits.empty()) { std::cout << 0; return; }
-  if (negative) std::cout << '-';
-  // print most significant
-  size_t i = digits.size() - 1;
-  std::cout << digits[i];
-  while (i-- > 0) {
-    uint32_t x = digits[i];
-    char buf[32];
-    std::snprintf(buf, sizeof(buf), "%0*u", BASE_DIGS, x);
-    std::cout << buf;
-  }
+size_t int2048::sqrScratch(size_t n) {
+  if (n < KARATSUBA_THRESHOLD) return 0;
+  size_t l = n - n / 2 + 1;
+  return 3 * l + sqrScratch(l);
 }
 
-int2048 &int2048::add(const int2048 &other) {
-  if (other.isZero()) return *this;
-  if (isZero()) { *this = other; return *this; }
-  if (negative == other.negative) {
-    absAdd(other);
-  } else {
-    int cmp = absCompare(other);
-    if (cmp == 0) { digits.clear(); negative = false; return *this; }
-    if (cmp > 0) {
-      absSub(other);
-      // sign remains this->negative
-    } else {
-      int2048 tmp = other;
-      tmp.absSub(*this);
-      *this = tmp;
+void int2048::sqrKaratsuba(const uint32_t *a, size_t n, uint32_t *out, uint32_t *scratch) {
+  if (n < KARATSUBA_THRESHOLD) {
+    sqrBasecase(a, n, out);
+    return;
+  }
+  size_t h = n / 2, l = n - h + 1;
+  uint32_t *sa = scratch;
+  uint32_t *mid = sa + l;
+  uint32_t *rest = mid + 2 * l;
+
+  std::copy(a + h, a + n, sa);
+  sa[n - h] = addLimbs(sa, n - h, a, h);
+
+  if (forkAt(n)) {
+    INT2048_OMP(omp parallel sections num_threads(parallelThreads))
+    {
+      INT2048_OMP(omp section)
+      {
+        ScratchFrame frame;
+        sqrKaratsuba(a, h, out, frame.alloc(sqrScratch(h)));
+      }
+      INT2048_OMP(omp section)
+      {
+        ScratchFrame frame;
+        sqrKaratsuba(a + h, n - h, out + 2 * h, frame.alloc(sqrScratch(n - h)));
+      }
+      INT2048_OMP(omp section)
+      {
+        ScratchFrame frame;
+        sqrKaratsuba(sa, l, mid, frame.alloc(sqrScratch(l)));
+      }
     }
+  } else {
+    sqrKaratsuba(a, h, out, rest);                 // a0^2 -> out[0, 2h)
+    sqrKaratsuba(a + h, n - h, out + 2 * h, rest); // a1^2 -> out[2h, 2n)
+    sqrKaratsuba(sa, l, mid, rest);                // (a0+a1)^2
   }
-  return *this;
+  subLimbs(mid, 2 * l, out, 2 * h);
+  subLimbs(mid, 2 * l, out + 2 * h, 2 * (n - h));
+  size_t midLen = 2 * l;
+  while (midLen > 0 && mid[midLen - 1] == 0) --midLen;
+  addLimbs(out + h, 2 * n - h, mid, midLen);
 }
 
-int2048 add(int2048 a, const int2048 &b) { return a.add(b); }
+void int2048::mulAbs(const Limbs &a, const Limbs &b, Limbs &out) {
+  const Limbs &x = (a.size() >= b.size() ? a : b);
+  const Limbs &y = (a.size() >= b.size() ? b : a);
+  if (y.empty()) { out.clear(); return; }
+  if (y.size() < KARATSUBA_THRESHOLD) {
+    INT2048_PROBE(ST_MUL_SCHOOLBOOK, x.size() + y.size());
+    mulSchoolbook(x, y, out);
+  } else if (y.size() < NTT_THRESHOLD) {
+    INT2048_PROBE(ST_MUL_KARATSUBA, x.size() + y.size());
+    out.assign(x.size() + y.size(), 0);
+    ScratchFrame frame;
+    uint32_t *scratch = frame.alloc(karatsubaScratch(x.size(), y.size()));
+    mulKaratsuba(x.data(), x.size(), y.data(), y.size(), out.data(), scratch);
+    while (!out.empty() && out.back() == 0) out.pop_back();
+  } else {
+    INT2048_PROBE(ST_MUL_NTT, x.size() + y.size());
+    mulNTT(x, y, out);
+  }
+}
 
-int2048 &int2048::minus(const int2048 &other) {
-  if (other.isZero()) return *this;
-  int2048 negOther = other;
-  if (!negOther.isZero()) negOther.negative = !negOther.negative;
-  return this->add(negOther);
+void int2048::sqrAbs(const Limbs &a, Limbs &out) {
+  const size_t n = a.size();
+  if (n < NTT_THRESHOLD) {
+    INT2048_PROBE(ST_SQR_KARATSUBA, n);
+    out.assign(2 * n, 0);
+    ScratchFrame frame;
+    uint32_t *scratch = frame.alloc(sqrScratch(n));
+    sqrKaratsuba(a.data(), n, out.data(), scratch);
+    while (!out.empty() && out.back() == 0) out.pop_back();
+  } else {
+    INT2048_PROBE(ST_SQR_NTT, n);
+    mulNTT(a, a, out);
+  }
 }
 
-int2048 minus(int2048 a, const int2048 &b) { return a.minus(b); }
+void int2048::mulSchoolbook(const Limbs &a, const Limbs &b, Limbs &out) {
+  out.assign(a.size() + b.size(), 0);
+  mulBasecase(a.data(), a.size(), b.data(), b.size(), out.data());
+  while (!out.empty() && out.back() == 0) out.pop_back();
+}
 
-int2048 int2048::operator+() const { return *this; }
+// NTT-friendly primes p = c * 2^k + 1, all with primitive root 3. Their
+// product (~7.8e25) bounds every convolution coefficient min(n,m)*(BASE-1)^2
+// for operands below 7.8e7 limbs, so CRT reconstruction is exact.
+static const uint32_t NTT_P1 = 998244353u; // 119 * 2^23 + 1
+static const uint32_t NTT_P2 = 167772161u; // 5 * 2^25 + 1
+static const uint32_t NTT_P3 = 469762049u; // 7 * 2^26 + 1
+static const uint32_t NTT_G = 3u;
 
-int2048 int2048::operator-() const {
-  int2048 r = *this;
-  if (!r.isZero()) r.negative = !r.negative;
-  return r;
+template <uint32_t P>
+static uint32_t powMod(uint32_t b, uint64_t e) {
+  uint64_t res = 1, x = b;
+  while (e) {
+    if (e & 1) res = res * x % P;
+    x = x * x % P;
+    e >>= 1;
+  }
+  return static_cast<uint32_t>(res);
 }
 
-int2048 &int2048::operator=(const int2048 &other) = default;
+// Montgomery arithmetic modulo P with R = 2^32: residues are kept as x*R
+// mod P so each product is reduced with two 32x32 multiplies and a shift
+// instead of a 64-bit remainder
+template <uint32_t P>
+struct Mont {
+  // -P^-1 mod 2^32 by Newton's iteration (each step doubles the correct bits)
+  static constexpr uint32_t inverse(uint32_t x, int steps) {
+    return steps == 0 ? x : inverse(x * (2u - P * x), steps - 1);
+  }
+  static const uint32_t NEG_INV = 0u - inverse(P, 4);
+  static const uint32_t R2 = static_cast<uint32_t>((0xFFFFFFFFFFFFFFFFull % P + 1) % P); // R^2 mod P
 
-int2048 &int2048::operator+=(const int2048 &rhs) { return this->add(rhs); }
+  // t * R^-1 mod P for t < P * 2^32, as a value in [0, 2P)
+  static uint32_t reduceLazy(uint64_t t) {
+    uint32_t m = static_cast<uint32_t>(t) * NEG_INV;
+    return static_cast<uint32_t>((t + (uint64_t)m * P) >> 32);
+  }
+  static uint32_t reduce(uint64_t t) {
+    uint32_t r = reduceLazy(t);
+    return r >= P ? r - P : r;
+  }
+  static uint32_t mul(uint32_t a, uint32_t b) { return reduce((uint64_t)a * b); }
+  static uint32_t mulLazy(uint32_t a, uint32_t b) { return reduceLazy((uint64_t)a * b); }
+  static uint32_t to(uint32_t x) { return mul(x, R2); } // any x < 2^32
+};
 
-int2048 operator+(int2048 a, const int2048 &b) { return a += b; }
+// twiddles w^0 .. w^(half-1) in Montgomery form for a root w of order 2*half
+template <uint32_t P>
+static void fillRoots(uint32_t *roots, size_t half, bool invert) {
+  typedef Mont<P> M;
+  uint32_t w = powMod<P>(NTT_G, (P - 1) / (2 * half));
+  if (invert) w = powMod<P>(w, P - 2);
+  w = M::to(w);
+  roots[0] = M::to(1);
+  for (size_t j = 1; j < half; ++j) roots[j] = M::mul(roots[j - 1], w);
+}
 
-int2048 &int2048::operator-=(const int2048 &rhs) { return this->minus(rhs); }
+// Forward transform of length n (a power of two) on Montgomery residues,
+// decimation in frequency: natural order in, bit-reversed order out. The
+// inverse below takes that order back, so the convolution never permutes.
+// Both keep values in [0, 2P) between stages (4P < 2^32 for our primes)
+// and leave the final reduction to the pointwise products.
+// 'roots' is caller-provided scratch of at least n/2 entries.
+template <uint32_t P>
+static void nttForward(uint32_t *a, size_t n, uint32_t *roots) {
+  typedef Mont<P> M;
+  for (size_t len = n; len >= 2; len >>= 1) {
+    const size_t half = len >> 1;
+    fillRoots<P>(roots, half, false);
+    for (size_t i = 0; i < n; i += len) {
+      uint32_t *lo = a + i;
+      uint32_t *hi = lo + half;
+      for (size_t j = 0; j < half; ++j) {
+        uint32_t u = lo[j], v = hi[j];
+        uint32_t t = u + v;
+        lo[j] = (t >= 2 * P ? t - 2 * P : t);
+        hi[j] = M::mulLazy(u + 2 * P - v, roots[j]);
+      }
+    }
+  }
+}
 
-int2048 operator-(int2048 a, const int2048 &b) { return a -= b; }
+// inverse of nttForward up to the factor n, decimation in time:
+// bit-reversed order in, natural order out
+template <uint32_t P>
+static void nttInverse(uint32_t *a, size_t n, uint32_t *roots) {
+  typedef Mont<P> M;
+  for (size_t len = 2; len <= n; len <<= 1) {
+    const size_t half = len >> 1;
+    fillRoots<P>(roots, half, true);
+    for (size_t i = 0; i < n; i += len) {
+      uint32_t *lo = a + i;
+      uint32_t *hi = lo + half;
+      for (size_t j = 0; j < half; ++j) {
+        uint32_t u = lo[j], v = M::mulLazy(hi[j], roots[j]);
+        uint32_t t = u + v, d = u + 2 * P - v;
+        lo[j] = (t >= 2 * P ? t - 2 * P : t);
+        hi[j] = (d >= 2 * P ? d - 2 * P : d);
+      }
+    }
+  }
+}
 
-int2048 &int2048::operator*=(const int2048 &rhs) {
-  if (this->isZero() || rhs.isZero()) { digits.clear(); negative = false; return *this; }
-  std::vector<uint32_t> prod;
-  mulSchoolbook(this->digits, rhs.digits, prod);
-  digits.swap(prod);
-  negative = (negative != rhs.negative);
-  trim();
-  return *this;
+// cyclic convolution of a[0, an) and b[0, bn) modulo P, written to res
+// (length n) as plain residues; a == b squares with a single forward transform
+template <uint32_t P>
+static void convolveMod(const uint32_t *a, size_t an, const uint32_t *b, size_t bn,
+                        size_t n, uint32_t *res, uint32_t *tmp, uint32_t *roots) {
+  typedef Mont<P> M;
+  std::fill(res, res + n, 0u);
+  for (size_t i = 0; i < an; ++i) res[i] = M::to(a[i]);
+  nttForward<P>(res, n, roots);
+  if (a == b && an == bn) {
+    for (size_t i = 0; i < n; ++i) res[i] = M::mul(res[i], res[i]);
+  } else {
+    std::fill(tmp, tmp + n, 0u);
+    for (size_t i = 0; i < bn; ++i) tmp[i] = M::to(b[i]);
+    nttForward<P>(tmp, n, roots);
+    for (size_t i = 0; i < n; ++i) res[i] = M::mul(res[i], tmp[i]);
+  }
+  nttInverse<P>(res, n, roots);
+  // multiplying by plain 1/n leaves Montgomery form at the same time
+  const uint32_t nInv = powMod<P>(static_cast<uint32_t>(n % P), P - 2);
+  for (size_t i = 0; i < n; ++i) res[i] = M::mul(res[i], nInv);
 }
 
-int2048 operator*(int2048 a, const int2048 &b) { return a *= b; }
+void int2048::mulNTT(const Limbs &a, const Limbs &b, Limbs &out) {
+  const size_t need = a.size() + b.size();
+  size_t n = 1;
+  while (n < need) n <<= 1;
+  // serially one scratch array and the twiddle table are shared by all
+  // three primes, so peak memory is 4n+n/2 words on top of the operands;
+  // in parallel each prime gets its own (6n+3n/2)
+  const bool parallel = forkAt(std::min(a.size(), b.size()));
+  ScratchFrame frame;
+  uint32_t *r1 = frame.alloc(n), *r2 = frame.alloc(n), *r3 = frame.alloc(n);
+  uint32_t *tmp1 = frame.alloc(n), *roots1 = frame.alloc(n / 2 + 1);
+  uint32_t *tmp2 = tmp1, *roots2 = roots1, *tmp3 = tmp1, *roots3 = roots1;
+  if (parallel) {
+    tmp2 = frame.alloc(n), roots2 = frame.alloc(n / 2 + 1);
+    tmp3 = frame.alloc(n), roots3 = frame.alloc(n / 2 + 1);
+  }
+  INT2048_OMP(omp parallel sections num_threads(parallelThreads) if (parallel))
+  {
+    INT2048_OMP(omp section)
+    convolveMod<NTT_P1>(a.data(), a.size(), b.data(), b.size(), n, r1, tmp1, roots1);
+    INT2048_OMP(omp section)
+    convolveMod<NTT_P2>(a.data(), a.size(), b.data(), b.size(), n, r2, tmp2, roots2);
+    INT2048_OMP(omp section)
+    convolveMod<NTT_P3>(a.data(), a.size(), b.data(), b.size(), n, r3, tmp3, roots3);
+  }
 
-int2048 &int2048::operator/=(const int2048 &rhs) {
-  // floor division
-  if (rhs.isZero()) return *this; // undefined
-  if (this->isZero()) { digits.clear(); negative = false; return *this; }
-  int2048 q, r;
-  divmodTrunc(*this, rhs, q, r);
-  // adjust to floor division
-  bool aNeg = this->negative;
-  bool bNeg = rhs.negative;
-  bool signsDifferent = (aNeg != bNeg);
-  if (signsDifferent && !r.isZero()) {
-    // q_floor = q_trunc - 1
-    int2048 one(1);
-    q = q.minus(one);
-  }
-  *this = q;
-  return *this;
-}
+  static const uint64_t inv1mod2 = powMod<NTT_P2>(NTT_P1 % NTT_P2, NTT_P2 - 2);
+  static const uint64_t p12 = (uint64_t)NTT_P1 * NTT_P2;
+  static const uint64_t inv12mod3 = powMod<NTT_P3>(static_cast<uint32_t>(p12 % NTT_P3), NTT_P3 - 2);
 
-int2048 operator/(int2048 a, const int2048 &b) { return a /= b; }
+  // coefficient = x12 + p12*t3; with p12 = p12hi*BASE + p12lo the running
+  // sum splits so that everything stays in 64 bits: x12 < 1.7e17,
+  // t3*p12lo < 4.7e17, and the carry stays below 1e17
+  static const uint64_t p12hi = p12 / BASE, p12lo = p12 % BASE;
 
-int2048 &int2048::operator%=(const int2048 &rhs) {
-  if (rhs.isZero()) return *this; // undefined
-  if (this->isZero()) { digits.clear(); negative = false; return *this; }
-  int2048 q, r;
-  divmodTrunc(*this, rhs, q, r); // trunc toward zero
-  bool signsDifferent = (this->negative != rhs.negative);
-  if (signsDifferent && !r.isZero()) {
-    // floor remainder: r_floor = r_trunc + rhs
-    r.add(rhs);
+  out.assign(need, 0);
+  uint64_t carry = 0;
+  for (size_t i = 0; i < need; ++i) {
+    uint64_t x1 = r1[i];
+    uint64_t t2 = (r2[i] + NTT_P2 - x1 % NTT_P2) % NTT_P2 * inv1mod2 % NTT_P2;
+    uint64_t x12 = x1 + NTT_P1 * t2;
+    uint64_t t3 = (r3[i] + NTT_P3 - x12 % NTT_P3) % NTT_P3 * inv12mod3 % NTT_P3;
+    uint64_t sum = x12 + t3 * p12lo + carry;
+    out[i] = static_cast<uint32_t>(sum % BASE);
+    carry = sum / BASE + t3 * p12hi;
   }
-  *this = r;
-  return *this;
+  while (!out.empty() && out.back() == 0) out.pop_back();
 }
 
-int2048 operator%(int2048 a, const int2048 &b) { return a %= b; }
+uint32_t int2048::mulWord(uint32_t *x, size_t n, uint32_t w) {
+  uint64_t carry = 0;
+  for (size_t i = 0; i < n; ++i) {
+    uint64_t cur = (uint64_t)x[i] * w + carry;
+    x[i] = static_cast<uint32_t>(cur % BASE);
+    carry = cur / BASE;
+  }
+  return static_cast<uint32_t>(carry);
+}
+
+// Division of cur < w * BASE (< 2^62 for any 32-bit w) by a run-time
+// constant w >= 2 through a precomputed inverse: inv <= 2^64/w is less than
+// two units short, so the estimate cur*inv/2^64 is at most one below the
+// quotient.
+class WordDivisor {
+public:
+  explicit WordDivisor(uint32_t w) : w(w), inv(~0ull / w) {}
+
+  uint32_t divmod(uint64_t cur, uint64_t &rem) const {
+    uint64_t q = static_cast<uint64_t>(((unsigned __int128)cur * inv) >> 64);
+    uint64_t r = cur - q * w;
+    if (r >= w) {
+      ++q;
+      r -= w;
+    }
+    rem = r;
+    return static_cast<uint32_t>(q);
+  }
+
+private:
+  uint64_t w, inv;
+};
+
+uint32_t int2048::divWord(uint32_t *x, size_t n, uint32_t w) {
+  if (w == 1) return 0;
+  const WordDivisor div(w);
+  uint64_t rem = 0;
+  for (size_t i = n; i-- > 0;) x[i] = div.divmod(rem * BASE + x[i], rem);
+  return static_cast<uint32_t>(rem);
+}
+
+uint32_t int2048::modWord(const uint32_t *x, size_t n, uint32_t w) {
+  if (w == 1) return 0;
+  const WordDivisor div(w);
+  uint64_t rem = 0;
+  for (size_t i = n; i-- > 0;) div.divmod(rem * BASE + x[i], rem);
+  return static_cast<uint32_t>(rem);
+}
+
+void int2048::divKnuth(uint32_t *u, size_t n, const uint32_t *v, size_t m, uint32_t *q) {
+  // Knuth, TAOCP vol. 2, 4.3.1 Algorithm D with B = BASE
+  const uint64_t v1 = v[m - 1], v2 = v[m - 2];
+  const WordDivisor top(v[m - 1]); // num below stays under (v1 + 1) * BASE
+  for (size_t j = n - m + 1; j-- > 0;) {
+    // D3: estimate from the top three limbs; qhat is then at most one too big
+    uint64_t num = (uint64_t)u[j + m] * BASE + u[j + m - 1];
+    uint64_t rhat;
+    uint64_t qhat = top.divmod(num, rhat);
+    while (qhat >= BASE || qhat * v2 > rhat * BASE + u[j + m - 2]) {
+      INT2048_EVENT(SE_QHAT_REFINE);
+      --qhat;
+      rhat += v1;
+      if (rhat >= BASE) break;
+    }
+    // D4: u[j, j+m] -= qhat * v in one fused pass
+    uint64_t carry = 0;
+    uint32_t borrow = 0;
+    for (size_t i = 0; i < m; ++i) {
+      uint64_t p = qhat * v[i] + carry;
+      carry = p / BASE;
+      uint32_t sub = static_cast<uint32_t>(p % BASE) + borrow;
+      borrow = (u[i + j] < sub);
+      u[i + j] = borrow ? u[i + j] + BASE - sub : u[i + j] - sub;
+    }
+    uint64_t sub = carry + borrow;
+    if (u[j + m] < sub) {
+      // D6: qhat was one too big, add v back (the carry out cancels the borrow)
+      INT2048_EVENT(SE_QHAT_ADD_BACK);
+      u[j + m] = static_cast<uint32_t>(u[j + m] + BASE - sub);
+      --qhat;
+      addLimbs(u + j, m + 1, v, m);
+    } else {
+      u[j + m] = static_cast<uint32_t>(u[j + m] - sub);
+    }
+    q[j] = static_cast<uint32_t>(qhat);
+  }
+}
+
+void int2048::div3n2n(const int2048 &a, const int2048 &b, size_t half, int2048 &q,
+                      int2048 &r) {
+  // a < b * BASE^half, a has up to 3 halves and b exactly 2
+  int2048 b1 = b, b2 = b;
+  b1.shiftLimbsRight(half);
+  b2.truncateLimbs(half);
+  int2048 a12 = a, a3 = a;
+  a12.shiftLimbsRight(half);
+  a3.truncateLimbs(half);
+  int2048 a1 = a12;
+  a1.shiftLimbsRight(half);
+  if (a1.absCompare(b1) < 0) {
+    div2n1n(a12, b1, half, q, r);
+  } else {
+    // the quotient limb block saturates at BASE^half - 1
+    q.digits.assign(half, BASE - 1);
+    q.negative = false;
+    r = a12 - b1 * q;
+  }
+  r.shiftLimbsLeft(half);
+  r += a3;
+  r -= q * b2;
+  // b is normalized, so at most two corrections are needed
+  while (r.negative) { q -= 1; r += b; }
+}
+
+void int2048::div2n1n(const int2048 &a, const int2048 &b, size_t n, int2048 &q, int2048 &r) {
+  // a < b * BASE^n, b has n limbs and is normalized
+  if ((n & 1) || n <= BZ_THRESHOLD) {
+    divSchool(a, b, q, r);
+    return;
+  }
+  const size_t half = n / 2;
+  int2048 hi = a, lo = a, q1;
+  hi.shiftLimbsRight(half);
+  lo.truncateLimbs(half);
+  div3n2n(hi, b, half, q1, r);
+  r.shiftLimbsLeft(half);
+  r += lo;
+  div3n2n(r, b, half, q, r);
+  q1.shiftLimbsLeft(half);
+  q += q1;
+}
+
+void int2048::divBZ(const int2048 &a, const int2048 &b, int2048 &q, int2048 &r) {
+  const size_t m = b.digits.size();
+  // block size n = j * 2^k >= m with j <= BZ_THRESHOLD, so div2n1n halves
+  // cleanly down to its leaves
+  size_t k = 0;
+  while ((m >> k) > BZ_THRESHOLD) ++k;
+  const size_t j = ((m - 1) >> k) + 1, n = j << k, sigma = n - m;
+  // normalize: shift the divisor to n limbs and scale its top limb to >= BASE/2
+  const uint32_t d = static_cast<uint32_t>(BASE / ((uint64_t)b.digits.back() + 1));
+  int2048 bn = b, an = a;
+  if (d > 1) {
+    mulWord(bn.digits.data(), m, d); // cannot carry out
+    uint32_t carry = mulWord(an.digits.data(), an.digits.size(), d);
+    if (carry) an.digits.push_back(carry);
+  }
+  bn.shiftLimbsLeft(sigma);
+  an.shiftLimbsLeft(sigma);
+  // t blocks of n limbs with the top block below bn
+  const size_t t = std::max<size_t>(2, (an.digits.size() + n) / n);
+  int2048 z = an, block;
+  z.shiftLimbsRight((t - 2) * n);
+  q.digits.clear();
+  q.negative = false;
+  for (size_t i = t - 1; i-- > 0;) {
+    int2048 qi;
+    div2n1n(z, bn, n, qi, r);
+    q.shiftLimbsLeft(n);
+    q += qi;
+    if (i > 0) {
+      block = an;
+      block.shiftLimbsRight((i - 1) * n);
+      block.truncateLimbs(n);
+      r.shiftLimbsLeft(n);
+      z = r + block;
+    }
+  }
+  r.shiftLimbsRight(sigma);
+  if (d > 1) divWord(r.digits.data(), r.digits.size(), d);
+  r.trim();
+}
+
+int2048 int2048::reciprocal(const int2048 &b) {
+  const size_t k = b.digits.size();
+  INT2048_PROBE(ST_RECIPROCAL, k);
+  int2048 pow; // BASE^(2k)
+  pow.digits.assign(2 * k, 0);
+  pow.digits.push_back(1);
+  if (k < NEWTON_THRESHOLD) {
+    int2048 q, r;
+    divmodTrunc(pow, b, q, r);
+    return q;
+  }
+  // x0 = xh * BASE^(k-h) from the top h limbs has relative error below
+  // BASE^(1-h); one Newton step squares it, and 2h >= k+3 leaves an
+  // absolute error of a couple of units for the fix-up loops below
+  const size_t h = (k + 4) / 2;
+  int2048 xh = b;
+  xh.shiftLimbsRight(k - h);
+  xh = reciprocal(xh);
+  // x = x0 + x0 * (BASE^(2k) - b*x0) / BASE^(2k); dropping the low k-2
+  // limbs of the error term costs less than one unit
+  int2048 e = b * xh;
+  e.shiftLimbsLeft(k - h);
+  e = pow - e;
+  e.shiftLimbsRight(k - 2);
+  int2048 x = xh * e;
+  x.shiftLimbsRight(h + 2);
+  xh.shiftLimbsLeft(k - h);
+  x += xh;
+  int2048 r = pow - b * x;
+  while (r.negative) { INT2048_EVENT(SE_NEWTON_FIXUP); x -= 1; r += b; }
+  while (r >= b) { INT2048_EVENT(SE_NEWTON_FIXUP); x += 1; r -= b; }
+  return x;
+}
+
+void int2048::divSchool(const int2048 &A, const int2048 &B, int2048 &Q, int2048 &R) {
+  // |A| = |B|*Q + R by Algorithm D; Q and R may alias A or B. The operands
+  // are consumed before Q and R are written, so both keep their buffers.
+  const size_t n = A.digits.size(), m = B.digits.size();
+  if (A.absCompare(B) < 0) {
+    R = A;
+    R.negative = false;
+    Q.digits.clear();
+    Q.negative = false;
+    return;
+  }
+  if (m == 1) {
+    INT2048_PROBE(ST_DIV_WORD, n);
+    const uint32_t w = B.digits[0];
+    if (&Q != &A) Q.digits.assign(A.digits.data(), A.digits.data() + n);
+    uint32_t rem = divWord(Q.digits.data(), n, w);
+    R.digits.clear();
+    if (rem) R.digits.push_back(rem);
+  } else {
+    INT2048_PROBE(ST_DIV_KNUTH, n + m);
+    // D1: scale so the top divisor limb is at least BASE/2
+    uint32_t d = static_cast<uint32_t>(BASE / ((uint64_t)B.digits[m - 1] + 1));
+    ScratchFrame frame;
+    uint32_t *v = frame.alloc(m), *u = frame.alloc(n + 1);
+    std::copy(B.digits.begin(), B.digits.end(), v);
+    std::copy(A.digits.begin(), A.digits.end(), u);
+    u[n] = 0;
+    if (d > 1) {
+      mulWord(v, m, d);
+      u[n] = mulWord(u, n, d);
+    }
+    Q.digits.resize(n - m + 1);
+    divKnuth(u, n, v, m, Q.digits.data());
+    if (d > 1) divWord(u, m, d);
+    R.digits.assign(u, u + m);
+  }
+  Q.negative = false;
+  Q.trim();
+  R.negative = false;
+  R.trim();
+}
+
+void int2048::divmodTrunc(const int2048 &A, const int2048 &B, int2048 &Q, int2048 &R) {
+  // Q and R may alias A or B
+  if (B.isZero()) return; // undefined
+  const bool qNeg = (A.negative != B.negative), rNeg = A.negative;
+  const size_t n = A.digits.size(), m = B.digits.size();
+  if (A.absCompare(B) < 0) {
+    R = A;
+    Q.digits.clear();
+    Q.negative = false;
+    return;
+  }
+  if (m >= BZ_THRESHOLD && n - m >= BZ_THRESHOLD) {
+    INT2048_PROBE(ST_DIV_BZ, n + m);
+    int2048 a = A, b = B;
+    a.negative = b.negative = false;
+    divBZ(a, b, Q, R);
+  } else {
+    divSchool(A, B, Q, R);
+  }
+  if (!Q.isZero()) Q.negative = qNeg;
+  if (!R.isZero()) R.negative = rNeg;
+}
+
+void int2048::divmodFloor(const int2048 &A, const int2048 &B, int2048 &Q, int2048 &R) {
+  // the fix-up needs B after Q and R are written
+  if (&Q == &B || &R == &B) {
+    const int2048 b = B;
+    divmodFloor(A, b, Q, R);
+    return;
+  }
+  divmodTrunc(A, B, Q, R);
+  if (!R.isZero() && R.negative != B.negative) {
+    // the signs differ: Q -= 1 and R += B, where |R| < |B|
+    Q.addSmall(1, true);
+    R.absSubFrom(B);
+    R.negative = B.negative;
+  }
+}
+
+void divmod(const int2048 &a, const int2048 &b, int2048 &q, int2048 &r) {
+  int2048::divmodFloor(a, b, q, r);
+}
+
+int2048_divisor::int2048_divisor(const int2048 &divisor) : d(divisor), norm(1) {
+  const size_t m = d.digits.size();
+  if (m >= 2) {
+    norm = static_cast<uint32_t>(int2048::BASE / ((uint64_t)d.digits.back() + 1));
+    scaled = d;
+    scaled.negative = false;
+    if (norm > 1) int2048::mulWord(scaled.digits.data(), m, norm); // cannot carry out
+  }
+  if (m >= BARRETT_THRESHOLD) {
+    int2048 abs = d;
+    abs.negative = false;
+    mu = int2048::reciprocal(abs);
+  }
+}
+
+void int2048_divisor::divmodAbs(const int2048 &a, int2048 *q, int2048 &r) const {
+  const size_t n = a.digits.size(), m = d.digits.size();
+  if (m == 0 || a.absCompare(d) < 0) { // m == 0 is undefined
+    if (q) *q = int2048();
+    r = a;
+    r.negative = false;
+    return;
+  }
+  int2048::Limbs quot, rem;
+  if (q) quot.assign(n - m + 1, 0);
+  if (m == 1) {
+    uint32_t w = d.digits[0], x;
+    if (q) {
+      std::copy(a.digits.begin(), a.digits.end(), quot.begin());
+      x = int2048::divWord(quot.data(), n, w);
+    } else {
+      x = int2048::modWord(a.digits.data(), n, w);
+    }
+    if (x) rem.push_back(x);
+  } else if (mu.isZero()) {
+    // Algorithm D against the stored normalized divisor
+    ScratchFrame frame;
+    uint32_t *u = frame.alloc(n + 1);
+    uint32_t *qs = q ? quot.data() : frame.alloc(n - m + 1);
+    std::copy(a.digits.begin(), a.digits.end(), u);
+    u[n] = norm > 1 ? int2048::mulWord(u, n, norm) : 0;
+    int2048::divKnuth(u, n, scaled.digits.data(), m, qs);
+    if (norm > 1) int2048::divWord(u, m, norm);
+    rem.assign(u, u + m);
+  } else {
+    // Barrett, m limbs of a at a time from the top: each step divides some
+    // x < BASE^(2m) with q = ((x / BASE^(m-1)) * mu) / BASE^(m+1), which is
+    // at most 2 short. The first x takes the top m+1..2m limbs; after that
+    // x = r * BASE^m + next block < |d| * BASE^m.
+    const size_t k = n > 2 * m ? (n - m - 1) / m : 0;
+    int2048 x, t, p;
+    x.digits.assign(a.digits.data() + k * m, a.digits.data() + n);
+    for (size_t i = k + 1; i-- > 0;) {
+      if (x.digits.size() >= m) {
+        t.digits.assign(x.digits.data() + m - 1, x.digits.data() + x.digits.size());
+        int2048::mulAbs(t.digits, mu.digits, p.digits);
+        p.shiftLimbsRight(m + 1);
+        int2048::mulAbs(p.digits, d.digits, t.digits);
+        x.absSub(t);
+        while (x.absCompare(d) >= 0) {
+          x.absSub(d);
+          p += 1;
+        }
+        if (q) std::copy(p.digits.begin(), p.digits.end(), quot.begin() + i * m);
+      }
+      if (i > 0) {
+        const uint32_t *block = a.digits.data() + (i - 1) * m;
+        x.shiftLimbsLeft(m);
+        if (x.isZero()) x.digits.assign(block, block + m);
+        else std::copy(block, block + m, x.digits.begin());
+        x.trim();
+      }
+    }
+    rem.swap(x.digits);
+  }
+  if (q) {
+    q->digits.swap(quot);
+    q->negative = false;
+    q->trim();
+  }
+  r.digits.swap(rem);
+  r.negative = false;
+  r.trim();
+}
+
+void int2048_divisor::divmod(const int2048 &a, int2048 &q, int2048 &r) const {
+  const bool aNeg = a.negative, dNeg = d.negative;
+  int2048 quot, rem;
+  divmodAbs(a, &quot, rem);
+  // truncated to floor: q_floor = -(|q| + 1), r_floor = d - r
+  if (aNeg != dNeg && !rem.isZero()) {
+    quot += 1;
+    rem.absSubFrom(d);
+  }
+  quot.negative = aNeg != dNeg && !quot.isZero();
+  rem.negative = dNeg && !rem.isZero();
+  q = std::move(quot);
+  r = std::move(rem);
+}
+
+int2048 int2048_divisor::div(const int2048 &a) const {
+  int2048 q, r;
+  divmod(a, q, r);
+  return q;
+}
+
+int2048 int2048_divisor::mod(const int2048 &a) const {
+  int2048 r;
+  divmodAbs(a, nullptr, r);
+  if (a.negative != d.negative && !r.isZero()) r.absSubFrom(d);
+  r.negative = d.negative && !r.isZero();
+  return r;
+}
+
+static bool isSpace(char c) { return c == ' ' || c == '\n' || c == '\t' || c == '\r'; }
+
+// value of the 8 decimal digits at p (all known to be '0'..'9')
+static uint32_t parse8(const char *p) {
+#if defined(__BYTE_ORDER__) && __BYTE_ORDER__ == __ORDER_LITTLE_ENDIAN__
+  // SWAR: combine neighbouring digits, then pairs, then quads; p[0] lands in
+  // the lowest byte, so it ends up as the most significant digit
+  uint64_t v;
+  std::memcpy(&v, p, sizeof(v));
+  v -= 0x3030303030303030ull;
+  v = (v * 10 + (v >> 8)) & 0x00FF00FF00FF00FFull;
+  v = (v * 100 + (v >> 16)) & 0x0000FFFF0000FFFFull;
+  v = (v * 10000 + (v >> 32)) & 0xFFFFFFFFull;
+  return static_cast<uint32_t>(v);
+#else
+  uint32_t x = 0;
+  for (int k = 0; k < 8; ++k) x = x * 10u + (uint32_t)(p[k] - '0');
+  return x;
+#endif
+}
+
+// true if all 8 bytes at p are '0'..'9'
+static bool isDigits8(const char *p) {
+  uint64_t v;
+  std::memcpy(&v, p, sizeof(v));
+  // a byte is below '0' iff subtracting 0x30 borrows into its top bit, and
+  // above '9' iff adding 0x46 carries into it (bytes >= 0x80 set it anyway)
+  return (((v - 0x3030303030303030ull) | (v + 0x4646464646464646ull) | v) &
+          0x8080808080808080ull) == 0;
+}
+
+void int2048::read(const std::string &s) { read(s.data(), s.size()); }
+
+void int2048::read(const char *s, size_t len) {
+  INT2048_PROBE(ST_PARSE, len / BASE_DIGS);
+  negative = false;
+  size_t i = 0;
+  while (i < len && isSpace(s[i])) ++i;
+  bool neg = false;
+  if (i < len && (s[i] == '+' || s[i] == '-')) {
+    neg = (s[i] == '-');
+    ++i;
+  }
+  while (i < len && s[i] == '0') ++i; // skip leading zeros
+  size_t j = i;
+  while (j + 8 <= len && isDigits8(s + j)) j += 8;
+  while (j < len && s[j] >= '0' && s[j] <= '9') ++j;
+
+  // limb k holds the digits [j-9(k+1), j-9k); full limbs are one digit plus
+  // an 8-digit SWAR step, only the most significant limb may be partial
+  const char *first = s + i;
+  const char *last = s + j;
+  digits.resize((j - i + BASE_DIGS - 1) / BASE_DIGS);
+  for (size_t k = 0; k < digits.size(); ++k, last -= BASE_DIGS) {
+    if ((size_t)(last - first) >= (size_t)BASE_DIGS) {
+      const char *p = last - BASE_DIGS;
+      digits[k] = (uint32_t)(p[0] - '0') * 100000000u + parse8(p + 1);
+    } else {
+      uint32_t x = 0;
+      for (const char *p = first; p < last; ++p) x = x * 10u + (uint32_t)(*p - '0');
+      digits[k] = x;
+    }
+  }
+  if (!digits.empty()) negative = neg;
+}
+
+// "00" "01" ... "99", so a limb is rendered two digits per lookup
+static const char DIGIT_PAIRS[201] =
+    "00010203040506070809101112131415161718192021222324252627282930313233343536373839"
+    "40414243444546474849505152535455565758596061626364656667686970717273747576777879"
+    "8081828384858687888990919293949596979899";
+
+// writes x < BASE as exactly BASE_DIGS digits ending just before p
+static void putLimb(char *p, uint32_t x) {
+  for (int k = 0; k < 4; ++k) {
+    std::memcpy(p -= 2, DIGIT_PAIRS + 2 * (x % 100), 2);
+    x /= 100;
+  }
+  *--p = static_cast<char>('0' + x);
+}
+
+static int decimalDigits(uint32_t x) {
+  int d = 1;
+  while (x >= 10) {
+    x /= 10;
+    ++d;
+  }
+  return d;
+}
+
+size_t int2048::decimalLength() const {
+  if (digits.empty()) return 1;
+  return (negative ? 1 : 0) + decimalDigits(digits.back()) + (digits.size() - 1) * BASE_DIGS;
+}
+
+char *int2048::to_chars(char *first, char *last) const {
+  INT2048_PROBE(ST_FORMAT, digits.size());
+  size_t len = decimalLength();
+  if ((size_t)(last - first) < len) return nullptr;
+  if (digits.empty()) {
+    *first = '0';
+    return first + 1;
+  }
+  char *end = first + len;
+  char *p = end;
+  for (size_t i = 0; i + 1 < digits.size(); ++i, p -= BASE_DIGS) putLimb(p, digits[i]);
+  uint32_t x = digits.back();
+  for (; x >= 10; x /= 10) *--p = static_cast<char>('0' + x % 10);
+  *--p = static_cast<char>('0' + x);
+  if (negative) *--p = '-';
+  return end;
+}
+
+void int2048::print() { std::cout << *this; }
+
+int2048 &int2048::add(const int2048 &other) { return addSigned(other, other.negative); }
+
+int2048 add(int2048 a, const int2048 &b) {
+  a.add(b);
+  return a;
+}
+
+int2048 &int2048::minus(const int2048 &other) { return addSigned(other, !other.negative); }
+
+int2048 minus(int2048 a, const int2048 &b) {
+  a.minus(b);
+  return a;
+}
+
+int2048 int2048::operator+() const { return *this; }
+
+int2048 int2048::operator-() const {
+  int2048 r = *this;
+  if (!r.isZero()) r.negative = !r.negative;
+  return r;
+}
+
+int2048 &int2048::operator=(const int2048 &other) = default;
+
+int2048 &int2048::operator=(int2048 &&other) noexcept {
+  if (this != &other) {
+    digits.swap(other.digits);
+    negative = other.negative;
+    other.digits.clear(); // keeps the old buffer around for reuse
+    other.negative = false;
+  }
+  return *this;
+}
+
+int2048 &int2048::operator+=(const int2048 &rhs) { return this->add(rhs); }
+
+int2048 operator+(int2048 a, const int2048 &b) {
+  a += b;
+  return a;
+}
+
+int2048 operator+(const int2048 &a, int2048 &&b) {
+  b += a;
+  return std::move(b);
+}
+
+int2048 &int2048::operator-=(const int2048 &rhs) { return this->minus(rhs); }
+
+int2048 operator-(int2048 a, const int2048 &b) {
+  a -= b;
+  return a;
+}
+
+int2048 operator-(const int2048 &a, int2048 &&b) {
+  // a - b = -(b) + a, computed in b's buffer
+  if (!b.isZero()) b.negative = !b.negative;
+  b += a;
+  return std::move(b);
+}
+
+int2048 &int2048::operator*=(const int2048 &rhs) {
+  if (this->isZero() || rhs.isZero()) { digits.clear(); negative = false; return *this; }
+  if (this == &rhs) return sqr();
+  Limbs prod;
+  mulAbs(this->digits, rhs.digits, prod);
+  digits.swap(prod);
+  negative = (negative != rhs.negative);
+  trim();
+  return *this;
+}
+
+int2048 operator*(const int2048 &a, const int2048 &b) {
+  if (&a == &b) return sqr(a);
+  int2048 res;
+  if (a.isZero() || b.isZero()) return res;
+  int2048::mulAbs(a.digits, b.digits, res.digits);
+  res.negative = (a.negative != b.negative);
+  return res;
+}
+
+int2048 &int2048::sqr() {
+  if (isZero()) return *this;
+  Limbs prod;
+  sqrAbs(digits, prod);
+  digits.swap(prod);
+  negative = false;
+  return *this;
+}
+
+int2048 &int2048::addMul(const int2048 &a, const int2048 &b) {
+  return mulAccumulate(a, b, a.negative != b.negative);
+}
+
+int2048 &int2048::subMul(const int2048 &a, const int2048 &b) {
+  return mulAccumulate(a, b, a.negative == b.negative);
+}
+
+int2048 &int2048::mulAccumulate(const int2048 &a, const int2048 &b, bool productNegative) {
+  if (a.isZero() || b.isZero()) return *this;
+  const int2048 &x = (a.digits.size() >= b.digits.size() ? a : b);
+  const int2048 &y = (&x == &a ? b : a);
+  const size_t n = x.digits.size(), m = y.digits.size();
+  if (m >= NTT_THRESHOLD) {
+    // the transform dwarfs one more pass over the product
+    int2048 prod;
+    mulAbs(x.digits, y.digits, prod.digits);
+    return addSigned(prod, productNegative);
+  }
+  // the product goes to scratch and is folded into *this in one carry
+  // pass; it is complete before digits changes, so a or b may be *this
+  ScratchFrame frame;
+  uint32_t *prod = frame.alloc(n + m);
+  if (m < KARATSUBA_THRESHOLD)
+    mulBasecase(x.digits.data(), n, y.digits.data(), m, prod);
+  else
+    mulKaratsuba(x.digits.data(), n, y.digits.data(), m, prod,
+                 frame.alloc(karatsubaScratch(n, m)));
+  size_t len = n + m;
+  while (prod[len - 1] == 0) --len;
+
+  if (isZero() || negative == productNegative) {
+    negative = productNegative;
+    if (digits.size() < len) digits.resize(len, 0);
+    if (addLimbs(digits.data(), digits.size(), prod, len)) digits.push_back(1);
+    return *this;
+  }
+  int cmp = (digits.size() == len ? 0 : (digits.size() < len ? -1 : 1));
+  for (size_t i = len; cmp == 0 && i-- > 0;)
+    if (digits[i] != prod[i]) cmp = (digits[i] < prod[i] ? -1 : 1);
+  if (cmp >= 0) {
+    subLimbs(digits.data(), digits.size(), prod, len);
+  } else {
+    subLimbs(prod, len, digits.data(), digits.size());
+    digits.assign(prod, prod + len);
+    negative = productNegative;
+  }
+  trim();
+  return *this;
+}
+
+int2048 sqr(const int2048 &a) {
+  int2048 res;
+  int2048::sqrAbs(a.digits, res.digits);
+  return res;
+}
+
+int2048 &int2048::operator/=(const int2048 &rhs) {
+  if (rhs.isZero()) return *this; // undefined
+  int2048 r;
+  divmodFloor(*this, rhs, *this, r);
+  return *this;
+}
+
+int2048 operator/(int2048 a, const int2048 &b) {
+  a /= b;
+  return a;
+}
+
+int2048 &int2048::operator%=(const int2048 &rhs) {
+  if (rhs.isZero()) return *this; // undefined
+  int2048 q;
+  divmodFloor(*this, rhs, q, *this);
+  return *this;
+}
+
+int2048 operator%(int2048 a, const int2048 &b) {
+  a %= b;
+  return a;
+}
+
+int2048 pow(const int2048 &base, unsigned long long exp) {
+  if (exp == 0) return int2048(1);
+  // left to right: the squarings carry the growth, and every multiplication
+  // is by base itself, which stays the short operand
+  int top = 63;
+  while (!(exp >> top & 1)) --top;
+  int2048 r = base;
+  for (int i = top - 1; i >= 0; --i) {
+    r.sqr();
+    if (exp >> i & 1) r *= base;
+  }
+  return r;
+}
+
+int2048 powmod(const int2048 &base, const int2048 &exp, const int2048 &mod) {
+  if (mod.isZero() || exp.negative) return int2048(); // undefined
+  int2048 m = mod;
+  m.negative = false;
+  const int2048 b = base % m;
+
+  // exponent bits, least significant first, 30 to a word
+  std::vector<uint32_t> bits;
+  int2048 e = exp;
+  while (!e.isZero()) {
+    bits.push_back(int2048::divWord(e.digits.data(), e.digits.size(), 1u << 30));
+    e.trim();
+  }
+  size_t len = bits.size() * 30;
+  while (len > 0 && !(bits[(len - 1) / 30] >> (len - 1) % 30 & 1)) --len;
+
+  int2048 r;
+  uint64_t w = 0;
+  if (m.digits.size() <= 2)
+    w = m.digits[0] + (m.digits.size() == 2 ? (uint64_t)m.digits[1] * int2048::BASE : 0);
+  if (w != 0 && w >> 32 == 0) {
+    // m < 2^32: plain words, every product fits in 64 bits
+    uint64_t x = 0;
+    for (size_t i = b.digits.size(); i-- > 0;) x = x * int2048::BASE + b.digits[i];
+    uint64_t acc = 1 % w;
+    for (size_t i = 0; i < len; ++i) {
+      if (bits[i / 30] >> i % 30 & 1) acc = acc * x % w;
+      x = x * x % w;
+    }
+    r = int2048((long long)acc);
+    if (mod.negative && !r.isZero()) r += mod;
+    return r;
+  }
+
+  // sliding window over the bits: runs of up to win bits ending in a one
+  // become a single multiplication by a precomputed odd power of b
+  const size_t win = len > 671 ? 6 : len > 239 ? 5 : len > 79 ? 4 : len > 23 ? 3 : len > 6 ? 2 : 1;
+  // products of two residues are below m^2, which the divisor reduces
+  // with no general division once it is set up
+  const int2048_divisor ctx(m);
+  std::vector<int2048> odd(size_t(1) << (win - 1)); // b, b^3, b^5, ...
+  odd[0] = b;
+  if (odd.size() > 1) {
+    int2048 b2;
+    int2048::sqrAbs(b.digits, b2.digits);
+    ctx.divmodAbs(b2, nullptr, b2);
+    for (size_t i = 1; i < odd.size(); ++i) {
+      int2048::mulAbs(odd[i - 1].digits, b2.digits, odd[i].digits);
+      ctx.divmodAbs(odd[i], nullptr, odd[i]);
+    }
+  }
+  bool started = false;
+  int2048 tmp;
+  for (size_t i = len; i-- > 0;) {
+    if (!(bits[i / 30] >> i % 30 & 1)) {
+      int2048::sqrAbs(r.digits, tmp.digits);
+      ctx.divmodAbs(tmp, nullptr, r);
+      continue;
+    }
+    size_t j = i + 1 >= win ? i + 1 - win : 0;
+    while (!(bits[j / 30] >> j % 30 & 1)) ++j;
+    size_t v = 0;
+    for (size_t t = i + 1; t-- > j;) v = v << 1 | (bits[t / 30] >> t % 30 & 1);
+    if (started) {
+      for (size_t s = j; s <= i; ++s) {
+        int2048::sqrAbs(r.digits, tmp.digits);
+        ctx.divmodAbs(tmp, nullptr, r);
+      }
+      int2048::mulAbs(r.digits, odd[v >> 1].digits, tmp.digits);
+      ctx.divmodAbs(tmp, nullptr, r);
+    } else {
+      r = odd[v >> 1];
+      started = true;
+    }
+    i = j;
+  }
+  if (!started) r = int2048(1); // exp == 0, and m > 1 here
+  if (mod.negative && !r.isZero()) r += mod;
+  return r;
+}
+
+bool int2048::lehmerMatrix(const int2048 &a, const int2048 &b, uint64_t floor, int64_t w[4]) {
+  // x and y are a and b in units of BASE^p, rounded down. Euclid runs on
+  // them with remainders r_i = (-1)^i (U_i x - V_i y); the true scaled
+  // remainder differs from r_i by less than max(U_i, V_i), so a quotient is
+  // certain when r_{i+1} and r_i - r_{i+1} both clear the cofactors they
+  // carry. The continuant bound V^2 < x keeps every cofactor below 2^30.
+  const size_t n = a.digits.size(), p = n - 2, bn = b.digits.size();
+  const uint64_t x = (uint64_t)a.digits[n - 1] * BASE + a.digits[n - 2];
+  const uint64_t y = (bn > p + 1 ? (uint64_t)b.digits[p + 1] * BASE : 0) + (bn > p ? b.digits[p] : 0);
+  uint64_t r0 = x, r1 = y, u0 = 1, v0 = 0, u1 = 0, v1 = 1;
+  int steps = 0;
+  while (r1 != 0) {
+    const uint64_t q = r0 / r1, r2 = r0 - q * r1;
+    if (q > r1 / v1) break; // v2 >= q*v1 > r1 > r2, and q*v1 might overflow
+    const uint64_t u2 = u0 + q * u1, v2 = v0 + q * v1;
+    if (r2 < floor || r2 < std::max(u2, v2) || r1 - r2 < std::max(u1 + u2, v1 + v2)) break;
+    r0 = r1;
+    r1 = r2;
+    u0 = u1;
+    u1 = u2;
+    v0 = v1;
+    v1 = v2;
+    ++steps;
+  }
+  if (steps == 0) return false;
+  const int64_t sign = steps % 2 ? -1 : 1;
+  w[0] = sign * (int64_t)u0;
+  w[1] = -sign * (int64_t)v0;
+  w[2] = -sign * (int64_t)u1;
+  w[3] = sign * (int64_t)v1;
+  return true;
+}
+
+void int2048::applyLehmer(int2048 &a, int2048 &b, const int64_t w[4]) {
+  // both results are known to be non-negative and below a; entries and
+  // limbs are under 2^30, so each column sum fits comfortably in 63 bits
+  const size_t n = a.digits.size();
+  INT2048_PROBE(ST_GCD_LEHMER, n);
+  b.digits.resize(n);
+  uint32_t *x = a.digits.data(), *y = b.digits.data();
+  const int64_t base = BASE;
+  int64_t cx = 0, cy = 0;
+  for (size_t i = 0; i < n; ++i) {
+    const int64_t xi = x[i], yi = y[i];
+    int64_t s = w[0] * xi + w[1] * yi + cx, t = w[2] * xi + w[3] * yi + cy;
+    cx = s / base;
+    s -= cx * base;
+    if (s < 0) s += base, --cx;
+    cy = t / base;
+    t -= cy * base;
+    if (t < 0) t += base, --cy;
+    x[i] = static_cast<uint32_t>(s);
+    y[i] = static_cast<uint32_t>(t);
+  }
+  a.trim();
+  b.trim();
+}
+
+void int2048::applyLehmerSigned(int2048 &x, int2048 &y, const int64_t w[4]) {
+  const uint64_t w0 = w[0] < 0 ? -w[0] : w[0], w1 = w[1] < 0 ? -w[1] : w[1];
+  const uint64_t w2 = w[2] < 0 ? -w[2] : w[2], w3 = w[3] < 0 ? -w[3] : w[3];
+  if ((x.negative == y.negative && !x.isZero() && !y.isZero()) || (w0 | w1 | w2 | w3) >> 31) {
+    int2048 nx = x * w[0], ny = y * w[3];
+    nx += y * w[1];
+    ny += x * w[2];
+    x = std::move(nx);
+    y = std::move(ny);
+    return;
+  }
+  // w has the sign pattern {+, -; -, +} or its negation, so w0*x and w1*y
+  // share a sign, as do w2*x and w3*y
+  const bool xNeg = w[0] && !x.isZero() ? (w[0] < 0) != x.negative : (w[1] < 0) != y.negative;
+  const bool yNeg = w[3] && !y.isZero() ? (w[3] < 0) != y.negative : (w[2] < 0) != x.negative;
+  const size_t n = std::max(x.digits.size(), y.digits.size());
+  x.digits.resize(n);
+  y.digits.resize(n);
+  uint32_t *xd = x.digits.data(), *yd = y.digits.data();
+  uint64_t cx = 0, cy = 0;
+  for (size_t i = 0; i < n; ++i) {
+    const uint64_t xi = xd[i], yi = yd[i];
+    const uint64_t s = w0 * xi + w1 * yi + cx, t = w2 * xi + w3 * yi + cy;
+    cx = s / BASE;
+    cy = t / BASE;
+    xd[i] = static_cast<uint32_t>(s - cx * BASE);
+    yd[i] = static_cast<uint32_t>(t - cy * BASE);
+  }
+  for (; cx; cx /= BASE) x.digits.push_back(static_cast<uint32_t>(cx % BASE));
+  for (; cy; cy /= BASE) y.digits.push_back(static_cast<uint32_t>(cy % BASE));
+  x.trim();
+  y.trim();
+  x.negative = xNeg && !x.isZero();
+  y.negative = yNeg && !y.isZero();
+}
+
+// (x, y) <- (n0*x + n1*y, n2*x + n3*y)
+static void combine(int2048 &x, int2048 &y, const int2048 n[4]) {
+  int2048 nx = n[0] * x, ny = n[3] * y;
+  nx.addMul(n[1], y);
+  ny.addMul(n[2], x);
+  x = std::move(nx);
+  y = std::move(ny);
+}
+
+void int2048::euclidStep(int2048 &a, int2048 &b, int2048 *x, int2048 *y, size_t pairs) {
+  int2048 q;
+  divmodTrunc(a, b, q, a);
+  std::swap(a, b);
+  for (size_t i = 0; i < pairs; ++i) {
+    x[i].subMul(q, y[i]);
+    std::swap(x[i], y[i]);
+  }
+}
+
+void int2048::hgcd(int2048 &a, int2048 &b, int2048 m[4]) {
+  const size_t n = a.digits.size(), s = n / 2 + 1;
+  INT2048_PROBE(ST_HGCD, n);
+  m[0] = 1;
+  m[1] = 0;
+  m[2] = 0;
+  m[3] = 1;
+  if (b.digits.size() <= s) return;
+  if (n < HGCD_THRESHOLD) {
+    int64_t w[4];
+    while (b.digits.size() > s) {
+      // two top limbs at BASE^p: a new b of r units stays above BASE^s
+      // while r >= BASE^(s-p), and p >= s - 1 here
+      const size_t p = a.digits.size() - 2;
+      if (lehmerMatrix(a, b, p >= s ? 0 : BASE, w)) {
+        applyLehmer(a, b, w);
+        applyLehmerSigned(m[0], m[2], w);
+        applyLehmerSigned(m[1], m[3], w);
+      } else {
+        euclidStep(a, b, m, m + 2, 2);
+      }
+    }
+    return;
+  }
+  // Schoenhage: the top half decides about the first quarter of the
+  // quotients, one division step follows, and the top of what is left
+  // (chosen so its own half-gcd stops near BASE^s) decides the rest
+  hgcdTop(a, b, n / 2, m);
+  if (b.digits.size() <= s) return;
+  euclidStep(a, b, m, m + 2, 2);
+  if (b.digits.size() <= s) return;
+  const size_t l = a.digits.size();
+  size_t k = 2 * s > l ? 2 * s - l : 0;
+  if (l - k >= n) k = l - n + 1; // keep the recursion shrinking
+  int2048 m2[4];
+  hgcdTop(a, b, k, m2);
+  combine(m[0], m[2], m2);
+  combine(m[1], m[3], m2);
+}
+
+void int2048::hgcdTop(int2048 &a, int2048 &b, size_t k, int2048 m[4]) {
+  int2048 a1, b1;
+  a1.digits.assign(a.digits.data() + k, a.digits.data() + a.digits.size());
+  b1.digits.assign(b.digits.data() + k, b.digits.data() + b.digits.size());
+  hgcd(a1, b1, m);
+  // (a, b) = m (a, b): the reduced tops, shifted back, plus m times the
+  // low limbs. Near the end the tops can misjudge a quotient; the result
+  // is still exact, only its sign or order may need fixing below
+  a.truncateLimbs(k);
+  b.truncateLimbs(k);
+  int2048 ta = m[0] * a, tb = m[3] * b;
+  ta.addMul(m[1], b);
+  tb.addMul(m[2], a);
+  a1.shiftLimbsLeft(k);
+  b1.shiftLimbsLeft(k);
+  a1 += ta;
+  b1 += tb;
+  a = std::move(a1);
+  b = std::move(b1);
+  if (a.negative) {
+    a.negative = false;
+    m[0].negate();
+    m[1].negate();
+  }
+  if (b.negative) {
+    b.negative = false;
+    m[2].negate();
+    m[3].negate();
+  }
+  if (a.absCompare(b) < 0) {
+    std::swap(a, b);
+    std::swap(m[0], m[2]);
+    std::swap(m[1], m[3]);
+  }
+}
+
+void int2048::gcdReduce(int2048 &a, int2048 &b, int2048 *u) {
+  int64_t w[4];
+  while (!b.isZero()) {
+    const size_t n = a.digits.size();
+    if (n <= 2) {
+      // both below BASE^2: finish on words, cofactors stay under 2^60
+      uint64_t x = a.digits[0] + (n == 2 ? (uint64_t)a.digits[1] * BASE : 0);
+      uint64_t y = b.digits[0] + (b.digits.size() == 2 ? (uint64_t)b.digits[1] * BASE : 0);
+      int64_t c[4] = {1, 0, 0, 1};
+      while (y != 0) {
+        const uint64_t q = x / y, r = x - q * y;
+        const int64_t c0 = c[2], c1 = c[3];
+        c[2] = c[0] - (int64_t)q * c[2];
+        c[3] = c[1] - (int64_t)q * c[3];
+        c[0] = c0;
+        c[1] = c1;
+        x = y;
+        y = r;
+      }
+      a = fromSmall(x, false);
+      b = int2048();
+      if (u) applyLehmerSigned(u[0], u[1], c);
+      return;
+    }
+    if (b.digits.size() + 1 < n) {
+      euclidStep(a, b, u, u + 1, u ? 1 : 0);
+    } else if (n >= HGCD_THRESHOLD) {
+      int2048 m[4];
+      hgcd(a, b, m);
+      if (u) combine(u[0], u[1], m);
+      if (!b.isZero()) euclidStep(a, b, u, u + 1, u ? 1 : 0);
+    } else if (lehmerMatrix(a, b, 0, w)) {
+      applyLehmer(a, b, w);
+      if (u) applyLehmerSigned(u[0], u[1], w);
+    } else {
+      euclidStep(a, b, u, u + 1, u ? 1 : 0);
+    }
+  }
+}
+
+int2048 gcd(const int2048 &a, const int2048 &b) {
+  int2048 x = a, y = b;
+  x.negative = y.negative = false;
+  if (x.absCompare(y) < 0) std::swap(x, y);
+  int2048::gcdReduce(x, y, nullptr);
+  return x;
+}
+
+int2048 lcm(const int2048 &a, const int2048 &b) {
+  if (a.isZero() || b.isZero()) return int2048();
+  int2048 r = a / gcd(a, b) * b;
+  r.negative = false;
+  return r;
+}
+
+int2048 xgcd(const int2048 &a, const int2048 &b, int2048 &x, int2048 &y) {
+  const bool aNeg = a.negative, bNeg = b.negative;
+  int2048 big = a, small = b;
+  big.negative = small.negative = false;
+  const bool swapped = big.absCompare(small) < 0;
+  if (swapped) std::swap(big, small);
+  // only big's cofactor is carried; small's follows from g = s*big + t*small
+  int2048 g = big, r = small, u[2] = {int2048(1), int2048()};
+  int2048::gcdReduce(g, r, u);
+  int2048 s, t;
+  if (small.isZero()) {
+    s = int2048(big.isZero() ? 0 : 1);
+  } else {
+    // the smallest pair has 0 <= s < small / g
+    s = u[0] % (small / g);
+    t = g;
+    t.subMul(s, big);
+    t /= small; // exact
+  }
+  if (swapped) std::swap(s, t);
+  if (aNeg) s.negate();
+  if (bNeg) t.negate();
+  x = std::move(s);
+  y = std::move(t);
+  return g;
+}
+
+int2048 modinv(const int2048 &a, const int2048 &m) {
+  if (m.isZero()) return int2048(); // undefined
+  int2048 big = m, small;
+  big.negative = false;
+  small = a % big;
+  // carry small's cofactor: at the end g = (...)*|m| + u[0]*small
+  int2048 u[2] = {int2048(), int2048(1)};
+  int2048::gcdReduce(big, small, u);
+  if (big.compareSmall(1, false) != 0) return int2048(); // no inverse
+  int2048 r = u[0] % m;
+  return r;
+}
+
+int2048 int2048::rootAbs(const int2048 &a, unsigned long long k, bool exact) {
+  const size_t n = a.digits.size();
+  if (k >= 30 * n) return int2048(1); // a < BASE^n < 2^(30n) <= 2^k
+  // a >= BASE^(n-1), so the root is at least BASE^lo
+  const size_t lo = (n - 1) / k;
+  int2048 x, p, q, r;
+  if (lo < 3) {
+    // from a double: with T the top limbs and e limbs below them,
+    // root = (T * BASE^rem)^(1/k) * BASE^q for e = k*q + rem, and the
+    // first factor is below 2^60. Logarithms keep BASE^rem in range
+    const size_t e = n > 3 ? n - 3 : 0, shift = e / k, rem = e % k;
+    double top = 0;
+    for (size_t i = n; i-- > e;) top = top * BASE + a.digits[i];
+    const double y = std::exp((std::log(top) + rem * std::log((double)BASE)) / k);
+    // the margin is far above the rounding error, so x starts above the root
+    x = fromSmall(static_cast<uint64_t>(y * (1 + 1e-12)) + 1, false);
+    x.shiftLimbsLeft(shift);
+    // Newton from above: x' = ((k-1)*x + a / x^(k-1)) / k is never below
+    // the root's floor and is at least one less than x while x^k > a.
+    // Operands are small here, or the root is, and a few steps suffice
+    for (bool first = true;; first = false) {
+      p = k == 2 ? x : pow(x, k - 1);
+      if (!first) {
+        if (k == 2) sqrAbs(x.digits, r.digits);
+        else mulAbs(p.digits, x.digits, r.digits);
+        if (r.absCompare(a) <= 0) return x;
+      }
+      divmodTrunc(a, p, q, r);
+      x *= k - 1;
+      x += q;
+      x /= k;
+    }
+  }
+
+  // the top n - k*h limbs have a root of about half as many limbs; their
+  // root plus one, shifted, is above ours by at most a few BASE^h, and
+  // with 2h < lo one Newton step takes that below a unit. Inner levels
+  // may land a unit or two high, which keeps x an upper bound here
+  const size_t h = (lo - 1) / 2;
+  int2048 t;
+  t.digits.assign(a.digits.data() + k * h, a.digits.data() + n);
+  x = rootAbs(t, k, false);
+  x.addSmall(1, false);
+  x.shiftLimbsLeft(h);
+
+  // the same step written as x - ceil((x^k - a) / (k x^(k-1))): the quotient
+  // is only as long as the error, so it comes from the top limbs, rounded
+  // so that it never exceeds the exact one and x stays at or above the floor
+  if (k == 2) {
+    sqrAbs(x.digits, t.digits);
+    p = x;
+  } else {
+    p = pow(x, k - 1);
+    mulAbs(p.digits, x.digits, t.digits);
+  }
+  t -= a; // positive: x is above the root
+  p *= k;
+  const size_t lt = t.digits.size(), ld = p.digits.size(), keep = lt + 3 > ld ? lt - ld + 3 : 0;
+  if (keep >= ld) {
+    divmodTrunc(t, p, q, r);
+  } else if (ld - keep >= lt) {
+    // t is at least two limbs shorter than the divisor: the step is below
+    // one, and the clamp below takes it as exactly one
+    q = 0;
+  } else {
+    int2048 tt, dd;
+    tt.digits.assign(t.digits.data() + (ld - keep), t.digits.data() + lt);
+    dd.digits.assign(p.digits.data() + (ld - keep), p.digits.data() + ld);
+    dd.addSmall(1, false);
+    divmodTrunc(tt, dd, q, r);
+  }
+  if (!r.isZero() || q.isZero()) q.addSmall(1, false);
+  if (!exact) {
+    x -= q;
+    return x;
+  }
+  if (k == 2) {
+    // (x - q)^2 - a = t - q*(2x - q), then step down while still above a
+    r = x;
+    r *= 2;
+    r -= q;
+    t.subMul(q, r);
+    x -= q;
+    while (t.compareSmall(0, false) > 0) {
+      t -= x;
+      t -= x;
+      t += 1;
+      x -= 1;
+    }
+    return x;
+  }
+  x -= q;
+  for (;;) {
+    p = pow(x, k);
+    if (p.absCompare(a) <= 0) return x;
+    x -= 1;
+  }
+}
+
+int2048 isqrt(const int2048 &a) { return iroot(a, 2); }
+
+int2048 iroot(const int2048 &a, unsigned long long k) {
+  if (k == 0 || (a.negative && k % 2 == 0)) return int2048(); // undefined
+  if (k == 1 || a.isZero()) return a;
+  int2048 abs = a;
+  abs.negative = false;
+  int2048 r = int2048::rootAbs(abs, k, true);
+  r.negative = a.negative;
+  return r;
+}
+
+int2048 int2048::fromSmall(uint64_t mag, bool neg) {
+  int2048 r;
+  for (; mag > 0; mag /= BASE) r.digits.push_back(static_cast<uint32_t>(mag % BASE));
+  r.negative = neg && !r.digits.empty();
+  return r;
+}
+
+void int2048::negate() {
+  if (!isZero()) negative = !negative;
+}
+
+int2048 &int2048::addSmall(uint64_t mag, bool neg) {
+  if (mag == 0) return *this;
+  if (mag >= BASE || isZero()) return addSigned(fromSmall(mag, neg), neg);
+  const uint32_t w = static_cast<uint32_t>(mag);
+  if (negative == neg) {
+    if (addLimbs(digits.data(), digits.size(), &w, 1)) digits.push_back(1);
+  } else if (digits.size() > 1 || digits[0] >= w) {
+    subLimbs(digits.data(), digits.size(), &w, 1); // stops at the first limb without borrow
+    trim();
+  } else {
+    digits[0] = w - digits[0];
+    negative = neg;
+  }
+  return *this;
+}
+
+int2048 &int2048::mulSmall(uint64_t mag, bool neg) {
+  if (isZero()) return *this;
+  if (mag == 0) {
+    digits.clear();
+    negative = false;
+    return *this;
+  }
+  if (mag >= BASE) return *this *= fromSmall(mag, neg);
+  uint32_t carry = mulWord(digits.data(), digits.size(), static_cast<uint32_t>(mag));
+  if (carry) digits.push_back(carry);
+  negative = (negative != neg);
+  return *this;
+}
+
+int2048 &int2048::divSmall(uint64_t mag, bool neg) {
+  if (mag == 0) return *this; // undefined
+  if (isZero()) return *this;
+  if (mag > 0xFFFFFFFFu) return *this /= fromSmall(mag, neg);
+  const bool qNeg = (negative != neg);
+  const uint32_t rem = divWord(digits.data(), digits.size(), static_cast<uint32_t>(mag));
+  trim();
+  if (qNeg && rem) {
+    // floor: one more unit of magnitude on a negative quotient
+    const uint32_t one = 1;
+    if (digits.empty()) digits.push_back(1);
+    else if (addLimbs(digits.data(), digits.size(), &one, 1)) digits.push_back(1);
+  }
+  negative = qNeg && !digits.empty();
+  return *this;
+}
+
+int2048 &int2048::modSmall(uint64_t mag, bool neg) {
+  if (mag == 0) return *this; // undefined
+  if (isZero()) return *this;
+  if (mag > 0xFFFFFFFFu) return *this %= fromSmall(mag, neg);
+  uint64_t rem = modWord(digits.data(), digits.size(), static_cast<uint32_t>(mag));
+  // floor: a nonzero remainder takes the divisor's sign
+  bool rNeg = negative;
+  if (rem && negative != neg) {
+    rem = mag - rem;
+    rNeg = neg;
+  }
+  return *this = fromSmall(rem, rNeg);
+}
+
+int int2048::compareSmall(uint64_t mag, bool neg) const {
+  const int sign = isZero() ? 0 : (negative ? -1 : 1);
+  const int otherSign = mag == 0 ? 0 : (neg ? -1 : 1);
+  if (sign != otherSign) return sign < otherSign ? -1 : 1;
+  if (sign == 0) return 0;
+  // fromSmall needs at most three limbs, which stay inline
+  const int cmp = absCompare(fromSmall(mag, neg));
+  return sign < 0 ? -cmp : cmp;
+}
 
 std::istream &operator>>(std::istream &in, int2048 &x) {
-  std::string s;
-  in >> s;
-  x.read(s);
+  // libstdc++ pulls a whole token out of the stream buffer in bulk, which is
+  // about twice as fast as any per-character loop over the public streambuf
+  // interface; the token buffer is reused, so steady-state reads neither
+  // allocate nor keep a second copy per value
+  static thread_local std::string token;
+  if (in >> token) x.read(token.data(), token.size());
   return in;
 }
 
 std::ostream &operator<<(std::ostream &out, const int2048 &x) {
-  if (x.digits.empty()) { out << 0; return out; }
-  if (x.negative) out << '-';
-  size_t i = x.digits.size() - 1;
-  out << x.digits[i];
-  while (i-- > 0) {
-    uint32_t val = x.digits[i];
-    char buf[32];
-    std::snprintf(buf, sizeof(buf), "%0*u", int2048::BASE_DIGS, val);
-    out << buf;
-  }
+  // render into one buffer and hand it to the stream in a single write
+  size_t len = x.decimalLength();
+  ScratchFrame frame;
+  char *buf = reinterpret_cast<char *>(frame.alloc((len + 3) / 4));
+  x.to_chars(buf, buf + len);
+  out.write(buf, len);
   return out;
 }
 
+// Batch evaluation works on the whole input in memory. Tokens are parsed in
+// place with read(ptr, len); results are formatted with to_chars straight
+// into the output string. With setThreads(n) the lines are cut into chunks
+// that threads take in turn, each formatting into its own string, and the
+// strings are joined in input order.
+static bool isBlank(char c) { return c == ' ' || c == '\t' || c == '\r'; }
+
+// optional sign followed by at least one decimal digit
+static bool isNumber(const char *p, const char *end) {
+  if (p < end && (*p == '+' || *p == '-')) ++p;
+  if (p == end) return false;
+  for (; p < end; ++p)
+    if (*p < '0' || *p > '9') return false;
+  return true;
+}
+
+static const size_t EVAL_CHUNK_BYTES = 1 << 16; // input per chunk when parallel
+
+void int2048::evaluateLines(const char *first, const char *last, std::string &out) {
+  int2048 a, b; // reused for every line
+  while (first < last) {
+    const char *eol = static_cast<const char *>(std::memchr(first, '\n', last - first));
+    if (!eol) eol = last;
+    // exactly three blank-separated tokens: a, op, b
+    const char *tok[3], *end[3];
+    const char *p = first;
+    int n = 0;
+    for (; n < 3; ++n) {
+      while (p < eol && isBlank(*p)) ++p;
+      if (p == eol) break;
+      tok[n] = p;
+      while (p < eol && !isBlank(*p)) ++p;
+      end[n] = p;
+    }
+    while (p < eol && isBlank(*p)) ++p;
+    const bool trailing = p != eol;
+    first = eol + 1;
+    if (n == 0) continue; // blank line
+    const char op = (n == 3 && !trailing && end[1] - tok[1] == 1) ? *tok[1] : 0;
+    if ((op != '+' && op != '-' && op != '*' && op != '/' && op != '%') ||
+        !isNumber(tok[0], end[0]) || !isNumber(tok[2], end[2])) {
+      out.push_back('\n');
+      continue;
+    }
+    a.read(tok[0], end[0] - tok[0]);
+    b.read(tok[2], end[2] - tok[2]);
+    switch (op) {
+    case '+': a += b; break;
+    case '-': a -= b; break;
+    case '*': a *= b; break;
+    case '/': a /= b; break;
+    case '%': a %= b; break;
+    }
+    const size_t at = out.size(), len = a.decimalLength();
+    out.resize(at + len + 1);
+    a.to_chars(&out[at], &out[at] + len);
+    out[at + len] = '\n';
+  }
+}
+
+// cuts [first, last) into pieces of about EVAL_CHUNK_BYTES that end just
+// after a newline; cuts gets first, the inner boundaries and last
+static void cutLines(const char *first, const char *last, std::vector<const char *> &cuts) {
+  cuts.assign(1, first);
+  while (last - cuts.back() > (ptrdiff_t)EVAL_CHUNK_BYTES) {
+    const char *p = cuts.back() + EVAL_CHUNK_BYTES;
+    const char *eol = static_cast<const char *>(std::memchr(p, '\n', last - p));
+    if (!eol) break;
+    cuts.push_back(eol + 1);
+  }
+  cuts.push_back(last);
+}
+
+void int2048::evaluate(const char *first, const char *last, std::string &out) {
+  if (parallelThreads <= 1 || last - first < (ptrdiff_t)(2 * EVAL_CHUNK_BYTES)) {
+    evaluateLines(first, last, out);
+    return;
+  }
+  std::vector<const char *> cuts;
+  cutLines(first, last, cuts);
+  const long chunks = static_cast<long>(cuts.size() - 1);
+  std::vector<std::string> parts(chunks);
+  INT2048_OMP(omp parallel for schedule(dynamic) num_threads(parallelThreads))
+  for (long c = 0; c < chunks; ++c) evaluateLines(cuts[c], cuts[c + 1], parts[c]);
+  size_t total = out.size();
+  for (long c = 0; c < chunks; ++c) total += parts[c].size();
+  out.reserve(total);
+  for (long c = 0; c < chunks; ++c) out += parts[c];
+}
+
+void int2048::evaluate(std::istream &in, std::ostream &out) {
+  // input comes in blocks of whole lines and output leaves one write per
+  // chunk, all from buffers reused block after block: holding either side
+  // whole costs more in fresh pages and regrowth copies than the extra
+  // calls do
+  const size_t blockBytes = 4 * std::max(parallelThreads, 4) * EVAL_CHUNK_BYTES;
+  std::streambuf *buf = in.rdbuf();
+  std::string input;
+  std::vector<const char *> cuts;
+  std::vector<std::string> parts;
+  size_t kept = 0; // unfinished line carried into the next block
+  for (bool more = true; more;) {
+    input.resize(kept + blockBytes);
+    const std::streamsize want = static_cast<std::streamsize>(blockBytes);
+    const std::streamsize got = buf->sgetn(&input[kept], want);
+    // pipes and filtering buffers may return less than asked before the
+    // end; only a read that returns nothing ends the input
+    more = got > 0;
+    const char *first = input.data(), *last = first + kept + got, *stop = last;
+    if (more) {
+      while (stop > first && stop[-1] != '\n') --stop;
+      if (stop == first) { // a line longer than the block: read on
+        kept = last - first;
+        continue;
+      }
+    }
+    cutLines(first, stop, cuts);
+    const long chunks = static_cast<long>(cuts.size() - 1);
+    if (parts.size() < cuts.size()) parts.resize(cuts.size());
+    INT2048_OMP(omp parallel for schedule(dynamic) num_threads(parallelThreads) if (parallelThreads > 1))
+    for (long c = 0; c < chunks; ++c) {
+      parts[c].clear();
+      evaluateLines(cuts[c], cuts[c + 1], parts[c]);
+    }
+    for (long c = 0; c < chunks; ++c) out.write(parts[c].data(), parts[c].size());
+    kept = last - stop;
+    std::memmove(&input[0], stop, kept);
+  }
+  out.flush();
+}
+
 bool operator==(const int2048 &a, const int2048 &b) {
   return a.negative == b.negative && a.digits == b.digits;
 }
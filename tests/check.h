@@ -0,0 +1,70 @@
+// Shared helpers for the differential test drivers in this directory.
+//
+// Each driver is a standalone program built like the benchmark, e.g.
+//   g++ -O2 -std=c++17 -Isrc/include tests/mul_test.cpp src/int2048.cpp -o mul_test
+// It prints the first few mismatches and a summary to stderr, and exits 1 if
+// any check failed.
+
+#pragma once
+
+#include "int2048.h"
+
+#include <cstdio>
+#include <cstdlib>
+#include <random>
+#include <sstream>
+#include <string>
+
+namespace check {
+
+inline int &failures() {
+  static int n = 0;
+  return n;
+}
+
+inline int &checks() {
+  static int n = 0;
+  return n;
+}
+
+// records one check; what describes the operands when it fails
+inline void expect(bool ok, const std::string &what) {
+  ++checks();
+  if (ok) return;
+  if (++failures() <= 10) std::fprintf(stderr, "FAIL: %s\n", what.c_str());
+}
+
+inline int summary(const char *name) {
+  std::fprintf(stderr, "%s: %d checks, %d failed\n", name, checks(), failures());
+  return failures() ? 1 : 0;
+}
+
+inline std::string str(const sjtu::int2048 &x) {
+  std::ostringstream out;
+  out << x;
+  return out.str();
+}
+
+// n random decimal digits without a leading zero
+inline std::string digits(std::mt19937_64 &rng, size_t n) {
+  std::string s(n, '0');
+  for (size_t i = 0; i < n; ++i) s[i] = static_cast<char>('0' + rng() % 10);
+  if (n > 0) s[0] = static_cast<char>('1' + rng() % 9);
+  return s;
+}
+
+// a value of n digits in one of the shapes that stress carries and limb
+// boundaries: random, all nines, a power of ten, or one below it
+inline sjtu::int2048 operand(std::mt19937_64 &rng, size_t n) {
+  std::string s;
+  switch (rng() % 6) {
+  case 0: s.assign(n, '9'); break;
+  case 1: s = "1" + std::string(n - 1, '0'); break;
+  case 2: s = n > 1 ? std::string(n - 1, '9') : "1"; break;
+  default: s = digits(rng, n); break;
+  }
+  if (rng() % 2) s = "-" + s;
+  return sjtu::int2048(s);
+}
+
+} // namespace check
@@ -0,0 +1,178 @@
+// Differential test for division: Algorithm D, Burnikel-Ziegler and the
+// Newton reciprocal (through int2048_divisor) against a plain long division
+// computed here, for truncating and floor division, all four sign
+// combinations and quotient/remainder outputs aliasing the operands. Sizes
+// straddle BZ_THRESHOLD (80 limbs), NEWTON_THRESHOLD (800 limbs) and n = 2m.
+// Past the reference's reach, a = b*q + r with |r| < |b| and the right sign
+// of r pins q and r down just as well.
+//
+//   g++ -O2 -std=c++17 -Isrc/include tests/div_test.cpp src/int2048.cpp -o div_test
+
+#include "check.h"
+
+#include <cstdint>
+#include <vector>
+
+using sjtu::int2048;
+
+namespace {
+
+const uint32_t BASE = 1000000000;
+typedef std::vector<uint32_t> Limbs; // base 10^9, little-endian, magnitudes only
+
+Limbs toLimbs(const int2048 &x) {
+  std::string s = check::str(x);
+  if (s[0] == '-') s.erase(0, 1);
+  Limbs v;
+  for (size_t end = s.size(); end > 0; end = end >= 9 ? end - 9 : 0) {
+    const size_t from = end >= 9 ? end - 9 : 0;
+    v.push_back(static_cast<uint32_t>(std::stoul(s.substr(from, end - from))));
+  }
+  while (!v.empty() && v.back() == 0) v.pop_back();
+  return v;
+}
+
+int2048 fromLimbs(const Limbs &v) {
+  std::string s = "0";
+  if (!v.empty()) {
+    s = std::to_string(v.back());
+    char buf[16];
+    for (size_t i = v.size() - 1; i-- > 0;) {
+      std::snprintf(buf, sizeof buf, "%09u", v[i]);
+      s += buf;
+    }
+  }
+  return int2048(s);
+}
+
+// compares b * w with r, both trimmed
+int compareScaled(const Limbs &b, uint32_t w, const Limbs &r) {
+  Limbs p(b.size() + 1);
+  uint64_t carry = 0;
+  for (size_t i = 0; i < b.size(); ++i) {
+    uint64_t t = static_cast<uint64_t>(b[i]) * w + carry;
+    p[i] = t % BASE;
+    carry = t / BASE;
+  }
+  p[b.size()] = static_cast<uint32_t>(carry);
+  while (!p.empty() && p.back() == 0) p.pop_back();
+  if (p.size() != r.size()) return p.size() < r.size() ? -1 : 1;
+  for (size_t i = p.size(); i-- > 0;)
+    if (p[i] != r[i]) return p[i] < r[i] ? -1 : 1;
+  return 0;
+}
+
+// r -= b * w, where b * w <= r
+void subScaled(Limbs &r, const Limbs &b, uint32_t w) {
+  uint64_t carry = 0;
+  int64_t borrow = 0;
+  for (size_t i = 0; i < r.size(); ++i) {
+    uint64_t t = (i < b.size() ? static_cast<uint64_t>(b[i]) * w : 0) + carry;
+    carry = t / BASE;
+    int64_t d = static_cast<int64_t>(r[i]) - static_cast<int64_t>(t % BASE) - borrow;
+    borrow = d < 0;
+    r[i] = static_cast<uint32_t>(d < 0 ? d + BASE : d);
+  }
+  while (!r.empty() && r.back() == 0) r.pop_back();
+}
+
+// |a| = |b| * q + r by long division, one quotient limb at a time
+void referenceDivmod(const int2048 &a, const int2048 &b, int2048 &q, int2048 &r) {
+  const Limbs x = toLimbs(a), y = toLimbs(b);
+  Limbs quot(x.size(), 0), rem;
+  for (size_t i = x.size(); i-- > 0;) {
+    rem.insert(rem.begin(), x[i]);
+    while (!rem.empty() && rem.back() == 0) rem.pop_back();
+    uint32_t lo = 0, hi = BASE - 1; // largest w with y * w <= rem
+    while (lo < hi) {
+      uint32_t mid = lo + (hi - lo + 1) / 2;
+      if (compareScaled(y, mid, rem) <= 0) lo = mid;
+      else hi = mid - 1;
+    }
+    quot[i] = lo;
+    if (lo) subScaled(rem, y, lo);
+  }
+  while (!quot.empty() && quot.back() == 0) quot.pop_back();
+  q = fromLimbs(quot);
+  r = fromLimbs(rem);
+}
+
+int2048 absOf(const int2048 &x) { return x < 0 ? -x : x; }
+
+// absQ and absR, if given, are the expected |a| / |b| and |a| % |b|
+void checkDivision(const int2048 &a, const int2048 &b, const int2048 *absQ, const int2048 *absR,
+                   const std::string &what) {
+  int2048 q, r, fq, fr;
+  int2048::divmodTrunc(a, b, q, r);
+  int2048::divmodFloor(a, b, fq, fr);
+  check::expect(b * q + r == a && absOf(r) < absOf(b) && (r == 0 || (r < 0) == (a < 0)),
+                "divmodTrunc identity, " + what);
+  check::expect(b * fq + fr == a && absOf(fr) < absOf(b) && (fr == 0 || (fr < 0) == (b < 0)),
+                "divmodFloor identity, " + what);
+  if (absQ) {
+    const int2048 rq = (a < 0) != (b < 0) ? -*absQ : *absQ, rr = a < 0 ? -*absR : *absR;
+    check::expect(q == rq && r == rr, "divmodTrunc vs expected, " + what);
+  }
+  check::expect(a / b == fq && a % b == fr, "/ and %, " + what);
+  int2048 dq, dr;
+  divmod(a, b, dq, dr);
+  check::expect(dq == fq && dr == fr, "divmod, " + what);
+
+  // outputs aliasing the operands, in every arrangement
+  int2048 x = a, y = b;
+  int2048::divmodTrunc(x, y, x, y);
+  check::expect(x == q && y == r, "divmodTrunc(a, b, a, b), " + what);
+  x = a, y = b;
+  int2048::divmodTrunc(x, y, y, x);
+  check::expect(y == q && x == r, "divmodTrunc(a, b, b, a), " + what);
+  x = a, y = b;
+  int2048::divmodFloor(x, y, x, y);
+  check::expect(x == fq && y == fr, "divmodFloor(a, b, a, b), " + what);
+  x = a, y = b;
+  int2048::divmodFloor(x, y, y, x);
+  check::expect(y == fq && x == fr, "divmodFloor(a, b, b, a), " + what);
+  x = a, y = b;
+  divmod(x, y, x, y);
+  check::expect(x == fq && y == fr, "divmod(a, b, a, b), " + what);
+}
+
+} // namespace
+
+int main() {
+  std::mt19937_64 rng(2018);
+  // divisor limbs around the thresholds; dividends around m, 2m and beyond
+  const size_t DIVISORS[] = {1, 2, 5, 79, 80, 81, 200, 799, 800, 801, 1500};
+  for (size_t m : DIVISORS) {
+    const size_t QUOTIENTS[] = {0, 1, 79, 80, 81, m - 1, m, m + 1, 2 * m + 5};
+    for (size_t extra : QUOTIENTS) {
+      const size_t n = m + extra;
+      const int2048 a = check::operand(rng, 9 * n), b = check::operand(rng, 9 * m);
+      if (b == 0) continue;
+      int2048 absQ, absR;
+      const bool reference = static_cast<double>(n) * m <= 1e6;
+      if (reference) referenceDivmod(a, b, absQ, absR);
+      const int2048 zero(0), bMinus1 = absOf(b) - 1;
+      for (int signs = 0; signs < 4; ++signs) {
+        const int2048 sa = signs & 1 ? -a : a, sb = signs & 2 ? -b : b;
+        const std::string what = std::to_string(n) + " / " + std::to_string(m) + " limbs, " +
+                                 (signs & 1 ? "-" : "+") + (signs & 2 ? "-" : "+");
+        checkDivision(sa, sb, reference ? &absQ : nullptr, reference ? &absR : nullptr, what);
+        // remainders of zero and of |b| - 1, where quotient estimates go wrong:
+        // |a*b| - 1 = |b| * (|a| - 1) + |b| - 1
+        const int2048 exact = sa * sb, absA = absOf(a), aMinus1 = absA - 1;
+        checkDivision(exact, sb, &absA, &zero, "exact multiple, " + what);
+        if (a != 0)
+          checkDivision(absOf(exact) - 1, sb, &aMinus1, &bMinus1, "multiple - 1, " + what);
+      }
+    }
+  }
+
+  // the Newton reciprocal behind int2048_divisor for divisors of 800+ limbs
+  for (size_t m : {800, 1100}) {
+    const int2048 b = check::operand(rng, 9 * m), a = check::operand(rng, 9 * (3 * m));
+    const sjtu::int2048_divisor d(b);
+    check::expect(d.div(a) == a / b && d.mod(a) == a % b,
+                  "divisor with reciprocal, " + std::to_string(m) + " limbs");
+  }
+  return check::summary("div_test");
+}
@@ -0,0 +1,90 @@
+// Test for int2048_divisor and powmod: div, mod and divmod on a prepared
+// divisor must match / and % for every sign combination. Divisors cover one
+// limb, the stored-normalization Algorithm D range (2-9 limbs) and the
+// Barrett range (10+ limbs), and dividends run far past twice the divisor so
+// that Barrett reduction corrects more than once. powmod is checked against
+// square-and-multiply with %.
+//
+//   g++ -O2 -std=c++17 -Isrc/include tests/divisor_test.cpp src/int2048.cpp -o divisor_test
+
+#include "check.h"
+
+using sjtu::int2048;
+using sjtu::int2048_divisor;
+
+namespace {
+
+int2048 referencePowmod(int2048 a, const int2048 &e, const int2048 &m) {
+  const std::string digits = check::str(e); // most significant first
+  int2048 r = int2048(1) % m;
+  a %= m;
+  for (char c : digits) {
+    // r = r^10 * a^digit
+    int2048 t = r;
+    for (int i = 1; i < 10; ++i) r = r * t % m;
+    for (int i = 0; i < c - '0'; ++i) r = r * a % m;
+  }
+  return r;
+}
+
+void checkDivisor(const int2048 &a, const int2048 &b, const std::string &what) {
+  const int2048_divisor d(b);
+  const int2048 q = a / b, r = a % b;
+  check::expect(d.div(a) == q, "div, " + what);
+  check::expect(d.mod(a) == r, "mod, " + what);
+  int2048 x, y;
+  d.divmod(a, x, y);
+  check::expect(x == q && y == r, "divmod, " + what);
+  x = a;
+  d.divmod(x, x, y);
+  check::expect(x == q && y == r, "divmod with q aliasing a, " + what);
+  y = a;
+  d.divmod(y, x, y);
+  check::expect(x == q && y == r, "divmod with r aliasing a, " + what);
+}
+
+} // namespace
+
+int main() {
+  std::mt19937_64 rng(2021);
+  // divisor digit counts: one limb, 2-9 limbs, then the Barrett range
+  const size_t DIVISORS[] = {1, 5, 9, 10, 18, 45, 81, 82, 90, 99, 200, 900, 3000};
+  for (size_t nb : DIVISORS) {
+    const int2048 b = check::operand(rng, nb);
+    for (size_t factor : {0, 1, 2, 3, 5, 9}) {
+      const size_t na = factor ? factor * nb + rng() % 20 : 1 + rng() % nb;
+      const int2048 a = check::operand(rng, na);
+      for (int signs = 0; signs < 4; ++signs) {
+        const int2048 sa = signs & 1 ? -a : a, sb = signs & 2 ? -b : b;
+        const std::string what = std::to_string(na) + " / " + std::to_string(nb) + " digits, " +
+                                 (signs & 1 ? "-" : "+") + (signs & 2 ? "-" : "+");
+        checkDivisor(sa, sb, what);
+        // exact multiples and one off them, where the remainder is 0 or
+        // next to it and the quotient estimate is most likely to be a unit off
+        const int2048 exact = sa * sb;
+        checkDivisor(exact, sb, "exact multiple, " + what);
+        checkDivisor(exact - 1, sb, "multiple - 1, " + what);
+        checkDivisor(exact + 1, sb, "multiple + 1, " + what);
+      }
+    }
+  }
+
+  // powmod across both reduction paths, with negative bases and moduli
+  for (size_t nm : {1, 9, 30, 81, 100, 400}) {
+    for (int i = 0; i < 4; ++i) {
+      int2048 m = check::operand(rng, nm);
+      if (m == 0) m = 7;
+      const int2048 a = check::operand(rng, nm + rng() % (2 * nm));
+      const int2048 e = int2048(check::digits(rng, 1 + rng() % 6));
+      const std::string what = check::str(a).substr(0, 12) + " ^ " + check::str(e) + " mod " +
+                               std::to_string(nm) + " digits";
+      check::expect(powmod(a, e, m) == referencePowmod(a, e, m), "powmod, " + what);
+    }
+  }
+  const int2048 m(check::digits(rng, 100));
+  check::expect(powmod(int2048(5), int2048(0), m) == 1, "powmod with e = 0");
+  check::expect(powmod(int2048(0), int2048(3), m) == 0, "powmod with a = 0");
+  check::expect(powmod(int2048(-2), int2048(3), m) == int2048(-8) % m, "powmod with a < 0");
+  check::expect(powmod(int2048(7), int2048(3), int2048(1)) == 0, "powmod mod 1");
+  return check::summary("divisor_test");
+}
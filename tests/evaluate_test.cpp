@@ -0,0 +1,131 @@
+// Test for the batch evaluator: hand-written lines with known results,
+// including malformed ones, through both overloads; then a long random input
+// checked line by line against the operators, serially and in parallel.
+//
+//   g++ -O2 -std=c++17 -Isrc/include tests/evaluate_test.cpp src/int2048.cpp -o evaluate_test
+// Add -fopenmp to exercise the parallel chunking.
+
+#include "check.h"
+
+#include <algorithm>
+#include <vector>
+
+using sjtu::int2048;
+
+namespace {
+
+struct Line {
+  const char *in, *out; // out is "" for lines that must print an empty line
+};
+
+const Line LINES[] = {
+    {"1 + 2", "3"},
+    {"  -7   /\t2 ", "-4"},
+    {"-7 % 2\r", "1"},
+    {"+5 - -5", "10"},
+    {"123456789012345678901234567890 * 0", "0"},
+    {"999999999999999999 * 999999999999999999", "999999999999999998000000000000000001"},
+    {"1 + 2 3", ""},
+    {"1 + 2x", ""},
+    {"1 + 2 +", ""},
+    {"1 ++ 2", ""},
+    {"1 ^ 2", ""},
+    {"1 +", ""},
+    {"x + 1", ""},
+    {"- + 1", ""},
+    {"17", ""},
+};
+
+std::string evalString(const std::string &input) {
+  std::string out;
+  int2048::evaluate(input.data(), input.data() + input.size(), out);
+  return out;
+}
+
+std::string evalStream(const std::string &input) {
+  std::istringstream in(input);
+  std::ostringstream out;
+  int2048::evaluate(in, out);
+  return out.str();
+}
+
+// hands out at most step bytes per read, like a pipe
+class ShortReads : public std::streambuf {
+public:
+  ShortReads(const std::string &s, std::streamsize step) : text(s), pos(0), step(step) {}
+
+protected:
+  std::streamsize xsgetn(char *s, std::streamsize n) override {
+    const std::streamsize left = static_cast<std::streamsize>(text.size() - pos);
+    const std::streamsize got = std::min({n, step, left});
+    text.copy(s, static_cast<size_t>(got), pos);
+    pos += static_cast<size_t>(got);
+    return got;
+  }
+  int_type underflow() override {
+    return pos < text.size() ? traits_type::to_int_type(text[pos]) : traits_type::eof();
+  }
+  int_type uflow() override {
+    return pos < text.size() ? traits_type::to_int_type(text[pos++]) : traits_type::eof();
+  }
+
+private:
+  const std::string &text;
+  size_t pos;
+  std::streamsize step;
+};
+
+std::string evalShortReads(const std::string &input, std::streamsize step) {
+  ShortReads buf(input, step);
+  std::istream in(&buf);
+  std::ostringstream out;
+  int2048::evaluate(in, out);
+  return out.str();
+}
+
+} // namespace
+
+int main() {
+  // every hand-written line on its own, then all of them with blank lines
+  // in between, which produce no output
+  std::string all, expected;
+  for (const Line &line : LINES) {
+    const std::string want = std::string(line.out) + "\n";
+    check::expect(evalString(line.in) == want, std::string("string: ") + line.in);
+    check::expect(evalStream(std::string(line.in) + "\n") == want,
+                  std::string("stream: ") + line.in);
+    all += std::string(line.in) + "\n\n";
+    expected += want;
+  }
+  check::expect(evalString(all) == expected, "all lines, string");
+  check::expect(evalStream(all) == expected, "all lines, stream");
+
+  // enough random lines to span several chunks and stream blocks
+  std::mt19937_64 rng(2023);
+  const char OPS[] = "+-*/%";
+  std::string input;
+  expected.clear();
+  for (int i = 0; i < 60000; ++i) {
+    int2048 a = check::operand(rng, 1 + rng() % 60), b = check::operand(rng, 1 + rng() % 30);
+    if (b == 0) b = 7;
+    const char op = OPS[rng() % 5];
+    input += check::str(a) + " " + op + " " + check::str(b) + (i % 3 ? "\n" : "\r\n");
+    int2048 r = a;
+    switch (op) {
+    case '+': r += b; break;
+    case '-': r -= b; break;
+    case '*': r *= b; break;
+    case '/': r /= b; break;
+    case '%': r %= b; break;
+    }
+    expected += check::str(r) + "\n";
+  }
+  check::expect(evalString(input) == expected, "random lines, string");
+  check::expect(evalStream(input) == expected, "random lines, stream");
+  check::expect(evalShortReads(input, 1000) == expected, "random lines, 1000-byte reads");
+  check::expect(evalShortReads(input, 7) == expected, "random lines, 7-byte reads");
+  int2048::setThreads(4);
+  check::expect(evalString(input) == expected, "random lines, string, parallel");
+  check::expect(evalStream(input) == expected, "random lines, stream, parallel");
+  return check::summary("evaluate_test");
+}
@@ -0,0 +1,93 @@
+// Differential test for gcd, lcm, xgcd and modinv: Lehmer and half-gcd
+// results against a Euclid loop on % for moderate sizes, and the defining
+// identities (Bezout, divisibility, cofactor bounds, lcm * gcd == |a * b|,
+// a * modinv(a, m) == 1 mod m) at every size. Operands include Fibonacci
+// neighbours, shared large factors, zeros and all sign combinations.
+//
+//   g++ -O2 -std=c++17 -Isrc/include tests/gcd_test.cpp src/int2048.cpp -o gcd_test
+
+#include "check.h"
+
+using sjtu::int2048;
+
+namespace {
+
+int2048 absOf(const int2048 &x) { return x < 0 ? -x : x; }
+
+int2048 euclid(int2048 a, int2048 b) {
+  a = absOf(a);
+  b = absOf(b);
+  while (b != 0) {
+    a %= b;
+    std::swap(a, b);
+  }
+  return a;
+}
+
+void checkPair(const int2048 &a, const int2048 &b, bool reference, const std::string &what) {
+  const int2048 g = gcd(a, b);
+  check::expect(g >= 0 && g == gcd(b, a) && g == gcd(-a, b), "gcd symmetry, " + what);
+  if (reference) check::expect(g == euclid(a, b), "gcd vs Euclid, " + what);
+
+  int2048 x, y;
+  check::expect(xgcd(a, b, x, y) == g, "xgcd value, " + what);
+  check::expect(a * x + b * y == g, "Bezout identity, " + what);
+  if (g != 0) {
+    // with the Bezout identity this makes g the greatest common divisor
+    check::expect(a % g == 0 && b % g == 0, "g divides a and b, " + what);
+    if (a != 0 && b != 0)
+      check::expect(absOf(x) <= absOf(b) / g && absOf(y) <= absOf(a) / g,
+                    "cofactor bounds, " + what);
+    check::expect(lcm(a, b) * g == absOf(a * b), "lcm * gcd, " + what);
+  }
+
+  if (b != 0) {
+    const int2048 inv = modinv(a, b);
+    if (g == 1) {
+      check::expect(inv % b == inv && (a * inv - 1) % b == 0, "modinv, " + what);
+    } else {
+      check::expect(inv == 0, "modinv without inverse, " + what);
+    }
+  }
+}
+
+} // namespace
+
+int main() {
+  std::mt19937_64 rng(2024);
+  // digit counts around the half-gcd threshold (150 limbs) and well past it
+  const size_t SIZES[] = {1, 9, 10, 19, 40, 200, 1000, 1350, 1400, 3000, 10000, 40000};
+
+  for (size_t na : SIZES) {
+    for (size_t nb : SIZES) {
+      if (nb > na) continue;
+      const bool reference = na <= 3000;
+      const std::string what = std::to_string(na) + " / " + std::to_string(nb) + " digits";
+      const int2048 a = check::operand(rng, na), b = check::operand(rng, nb);
+      checkPair(a, b, reference, what);
+      // a large common factor, so that g is far from 1
+      const int2048 f = check::operand(rng, nb);
+      checkPair(a * f, b * f, reference && na <= 1400, "common factor, " + what);
+    }
+  }
+
+  // consecutive Fibonacci numbers take the most Euclid steps per digit
+  int2048 f0(0), f1(1);
+  for (int i = 1; i <= 60000; ++i) {
+    f0 += f1;
+    std::swap(f0, f1);
+    if (i == 50 || i == 500 || i == 5000 || i == 60000) {
+      const std::string what = "Fibonacci " + std::to_string(i);
+      checkPair(f1, f0, i <= 5000, what);
+      checkPair(-f0, f1, false, what + ", negated");
+    }
+  }
+
+  // zeros, units and equal operands
+  const int2048 big = check::operand(rng, 5000);
+  const int2048 edge[] = {int2048(0), int2048(1), int2048(-1), int2048(2), big, -big};
+  for (const int2048 &a : edge)
+    for (const int2048 &b : edge)
+      checkPair(a, b, true, check::str(a).substr(0, 12) + " / " + check::str(b).substr(0, 12));
+  return check::summary("gcd_test");
+}
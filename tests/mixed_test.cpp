@@ -0,0 +1,77 @@
+// Test for the mixed-type operators: every arithmetic, compound-assignment
+// and comparison operator with a built-in integer on either side must agree
+// with the same operation on int2048(v). Covers the extremes of each type
+// (LLONG_MIN, ULLONG_MAX), divisors above 2^32, zero, and floor division
+// for all sign combinations.
+//
+//   g++ -O2 -std=c++17 -Isrc/include tests/mixed_test.cpp src/int2048.cpp -o mixed_test
+
+#include "check.h"
+
+#include <climits>
+#include <vector>
+
+using sjtu::int2048;
+
+namespace {
+
+template <class T> int2048 big(T v) { return int2048(std::to_string(v)); }
+
+template <class T> void checkOperand(const int2048 &x, T v) {
+  const int2048 y = big(v);
+  const std::string what = check::str(x).substr(0, 24) + " and " + std::to_string(v);
+  check::expect(x + v == x + y && v + x == y + x, "+, " + what);
+  check::expect(x - v == x - y && v - x == y - x, "-, " + what);
+  check::expect(x * v == x * y && v * x == y * x, "*, " + what);
+  if (v != 0) {
+    check::expect(x / v == x / y && x % v == x % y, "x / v and x % v, " + what);
+    int2048 q = x, r = x;
+    q /= v;
+    r %= v;
+    check::expect(q == x / y && r == x % y, "/= and %=, " + what);
+  }
+  if (x != 0) check::expect(v / x == y / x && v % x == y % x, "v / x and v % x, " + what);
+
+  int2048 s = x, d = x, p = x;
+  s += v;
+  d -= v;
+  p *= v;
+  check::expect(s == x + y && d == x - y && p == x * y, "+=, -= and *=, " + what);
+
+  check::expect((x == v) == (x == y) && (v == x) == (y == x), "==, " + what);
+  check::expect((x != v) == (x != y) && (v != x) == (y != x), "!=, " + what);
+  check::expect((x < v) == (x < y) && (v < x) == (y < x), "<, " + what);
+  check::expect((x > v) == (x > y) && (v > x) == (y > x), ">, " + what);
+  check::expect((x <= v) == (x <= y) && (v <= x) == (y <= x), "<=, " + what);
+  check::expect((x >= v) == (x >= y) && (v >= x) == (y >= x), ">=, " + what);
+}
+
+template <class T> void checkValues(const std::vector<int2048> &xs, const std::vector<T> &vs) {
+  for (const int2048 &x : xs)
+    for (T v : vs) checkOperand(x, v);
+}
+
+} // namespace
+
+int main() {
+  std::mt19937_64 rng(2016);
+  std::vector<int2048> xs;
+  for (const char *s : {"0", "1", "7", "999999999", "1000000000", "4294967295", "4294967296",
+                        "4294967297", "9223372036854775807", "9223372036854775808",
+                        "18446744073709551615", "18446744073709551616",
+                        "1000000000000000000000000000"}) {
+    xs.push_back(int2048(s));
+    xs.push_back(-int2048(s));
+  }
+  for (size_t n : {20, 40, 300}) xs.push_back(check::operand(rng, n));
+
+  checkValues<int>(xs, {0, 1, -1, 7, -7, 1000000000, -1000000000, INT_MAX, INT_MIN});
+  checkValues<unsigned>(xs, {0u, 1u, 7u, 999999999u, 1000000000u, UINT_MAX});
+  checkValues<long long>(xs, {0LL, -1LL, 4294967296LL, -4294967297LL, 1000000000000000000LL,
+                              -999999999999999999LL, LLONG_MAX, LLONG_MIN, LLONG_MIN + 1});
+  checkValues<unsigned long long>(xs, {0ULL, 1ULL, 4294967296ULL, 9223372036854775808ULL,
+                                       10000000000000000000ULL, ULLONG_MAX});
+  checkValues<short>(xs, {0, -1, SHRT_MIN, SHRT_MAX});
+  checkValues<unsigned char>(xs, {0, 1, 255});
+  return check::summary("mixed_test");
+}
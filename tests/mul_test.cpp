@@ -0,0 +1,136 @@
+// Differential test for multiplication: every tier (schoolbook, Karatsuba,
+// NTT, squaring, addMul/subMul with and without aliased operands) against a
+// plain schoolbook product computed here, then the same products and
+// quotients in parallel mode, which must be identical to the serial ones.
+//
+//   g++ -O2 -std=c++17 -Isrc/include tests/mul_test.cpp src/int2048.cpp -o mul_test
+// Add -fopenmp to exercise the parallel paths; without it they run serially.
+
+#include "check.h"
+
+#include <cstdint>
+#include <vector>
+
+using sjtu::int2048;
+
+namespace {
+
+// reference arithmetic on base-10^9 limbs, little-endian, magnitudes only
+typedef std::vector<uint32_t> Limbs;
+
+Limbs toLimbs(const std::string &s) {
+  size_t begin = s[0] == '-' ? 1 : 0;
+  Limbs x;
+  for (size_t end = s.size(); end > begin; end = end >= begin + 9 ? end - 9 : begin) {
+    size_t from = end >= begin + 9 ? end - 9 : begin;
+    x.push_back(static_cast<uint32_t>(std::stoul(s.substr(from, end - from))));
+  }
+  while (!x.empty() && x.back() == 0) x.pop_back();
+  return x;
+}
+
+std::string fromLimbs(const Limbs &x, bool negative) {
+  if (x.empty()) return "0";
+  std::string s = negative ? "-" : "";
+  s += std::to_string(x.back());
+  char buf[16];
+  for (size_t i = x.size() - 1; i-- > 0;) {
+    std::snprintf(buf, sizeof buf, "%09u", x[i]);
+    s += buf;
+  }
+  return s;
+}
+
+std::string referenceProduct(const std::string &a, const std::string &b) {
+  Limbs x = toLimbs(a), y = toLimbs(b);
+  if (x.empty() || y.empty()) return "0";
+  std::vector<uint64_t> acc(x.size() + y.size(), 0);
+  for (size_t i = 0; i < x.size(); ++i) {
+    uint64_t carry = 0;
+    for (size_t j = 0; j < y.size(); ++j) {
+      uint64_t t = acc[i + j] + static_cast<uint64_t>(x[i]) * y[j] + carry;
+      acc[i + j] = t % 1000000000;
+      carry = t / 1000000000;
+    }
+    acc[i + y.size()] += carry;
+  }
+  Limbs z(acc.begin(), acc.end());
+  while (!z.empty() && z.back() == 0) z.pop_back();
+  return fromLimbs(z, (a[0] == '-') != (b[0] == '-'));
+}
+
+// digit counts around the Karatsuba (64 limbs) and NTT (3000 limbs) cut-overs
+const size_t SIZES[] = {1,   9,    10,   18,   19,   36,   37,    300,   575,   576,  577,
+                        700, 1150, 2000, 5000, 9000, 26000, 26991, 27000, 27009, 32000};
+
+} // namespace
+
+int main() {
+  std::mt19937_64 rng(2017);
+  std::vector<int2048> as, bs;
+  std::vector<std::string> products, squares; // squares[i] empty unless a == b in size
+
+  for (size_t na : SIZES) {
+    for (size_t nb : SIZES) {
+      if (nb > na || (na > 5000 && nb > 64 && nb != na)) continue;
+      int2048 a = check::operand(rng, na), b = check::operand(rng, nb);
+      const std::string sa = check::str(a), sb = check::str(b);
+      const std::string what = std::to_string(na) + " x " + std::to_string(nb) + " digits";
+      const std::string expected = referenceProduct(sa, sb);
+      int2048 p = a * b;
+      check::expect(check::str(p) == expected, "a * b, " + what);
+      check::expect(check::str(b * a) == expected, "b * a, " + what);
+      int2048 acc(1);
+      acc.addMul(a, b);
+      acc.subMul(b, a);
+      check::expect(check::str(acc) == "1", "addMul/subMul, " + what);
+      // the accumulator may also be an operand; products checked above
+      // give the expected values
+      int2048 x = b;
+      x.addMul(a, x);
+      check::expect(x == b + p, "x.addMul(a, x), " + what);
+      x = a;
+      x.subMul(x, b);
+      check::expect(x == a - p, "x.subMul(x, b), " + what);
+      x = a;
+      x.addMul(x, x);
+      check::expect(x == a + a * a, "x.addMul(x, x), " + what);
+      x = a;
+      x.subMul(b, b);
+      check::expect(x == a - b * b, "x.subMul(b, b), " + what);
+      x = b;
+      x.subMul(x, x);
+      check::expect(x == b - b * b, "x.subMul(x, x), " + what);
+      as.push_back(a);
+      bs.push_back(b);
+      products.push_back(expected);
+      squares.push_back("");
+      if (nb == na) {
+        const std::string sq = referenceProduct(sa, sa);
+        check::expect(check::str(sqr(a)) == sq, "sqr(a), " + what);
+        int2048 t = a;
+        t *= t;
+        check::expect(check::str(t) == sq, "a *= a, " + what);
+        squares.back() = sq;
+      }
+    }
+  }
+
+  // the same operands in parallel mode, with a low threshold so that
+  // Karatsuba levels and NTT primes split across threads
+  int2048::setThreads(4);
+  int2048::setParallelThreshold(32);
+  for (size_t i = 0; i < as.size(); ++i) {
+    const std::string what = std::to_string(i) + " (parallel)";
+    const int2048 p = as[i] * bs[i];
+    check::expect(check::str(p) == products[i], "a * b, case " + what);
+    if (!squares[i].empty())
+      check::expect(check::str(sqr(as[i])) == squares[i], "sqr(a), case " + what);
+    if (bs[i] != 0) {
+      // Newton and Burnikel-Ziegler division multiply through the same paths
+      check::expect(p / bs[i] == as[i], "a * b / b, case " + what);
+      check::expect(p % bs[i] == 0, "a * b % b, case " + what);
+    }
+  }
+  return check::summary("mul_test");
+}
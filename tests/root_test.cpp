@@ -0,0 +1,78 @@
+// Test for isqrt and iroot: r = iroot(a, k) must satisfy r^k <= a < (r+1)^k,
+// checked with pow, for random radicands and for the values next to perfect
+// powers (n^k - 1, n^k, n^k + 1 and 10^(k*m) - 1), where n sits on limb
+// boundaries. Those make the last Newton correction shorter than a limb.
+//
+//   g++ -O2 -std=c++17 -Isrc/include tests/root_test.cpp src/int2048.cpp -o root_test
+
+#include "check.h"
+
+using sjtu::int2048;
+
+namespace {
+
+void checkRoot(const int2048 &a, unsigned long long k, const std::string &what) {
+  const int2048 r = k == 2 ? isqrt(a) : iroot(a, k);
+  const std::string where = what + ", k = " + std::to_string(k);
+  check::expect(r >= 0 && pow(r, k) <= a && pow(r + 1, k) > a, "root bounds, " + where);
+  if (k % 2) check::expect(iroot(-a, k) == -r, "odd root of -a, " + where);
+}
+
+// n^k - 1, n^k and n^k + 1 have roots n - 1, n and n
+void checkPower(const int2048 &n, unsigned long long k, const std::string &what) {
+  const int2048 p = pow(n, k);
+  const std::string where = what + ", k = " + std::to_string(k);
+  check::expect(iroot(p - 1, k) == n - 1, "root of n^k - 1, " + where);
+  check::expect(iroot(p, k) == n, "root of n^k, " + where);
+  check::expect(iroot(p + 1, k) == n, "root of n^k + 1, " + where);
+}
+
+} // namespace
+
+int main() {
+  std::mt19937_64 rng(2025);
+  const unsigned long long KS[] = {2, 3, 4, 5, 7, 16, 100};
+
+  // random radicands, from the double-seeded sizes up through several
+  // levels of recursion on the top limbs
+  const size_t DIGITS[] = {1, 9, 18, 19, 27, 60, 100, 300, 1000, 3000, 10000};
+  for (size_t d : DIGITS)
+    for (unsigned long long k : KS)
+      for (int i = 0; i < 4; ++i) {
+        int2048 a = check::operand(rng, d);
+        checkRoot(a < 0 ? -a : a, k, std::to_string(d) + " digits");
+      }
+  checkRoot(int2048(check::digits(rng, 60000)), 2, "60000 digits");
+  checkRoot(int2048(check::digits(rng, 60000)), 3, "60000 digits");
+
+  // 10^(k*m) - 1: all nines, whose root is 10^m - 1
+  for (unsigned long long k : KS)
+    for (size_t m : {1, 8, 9, 10, 25, 50, 80, 275, 1000}) {
+      const int2048 p = pow(int2048(10), k * m);
+      const std::string what = "10^(k*" + std::to_string(m) + ") - 1";
+      check::expect(iroot(p - 1, k) == pow(int2048(10), m) - 1,
+                    what + ", k = " + std::to_string(k));
+    }
+
+  // n around BASE^j, and random n of a whole number of limbs
+  for (size_t j : {1, 2, 3, 4, 7, 20, 100}) {
+    const int2048 base = pow(int2048(1000000000), j);
+    for (unsigned long long k : KS) {
+      if (k * j > 4000) continue;
+      const std::string what = "n near 10^" + std::to_string(9 * j);
+      checkPower(base, k, what);
+      checkPower(base - 1, k, what);
+      checkPower(base + 1, k, what);
+      checkPower(int2048(check::digits(rng, 9 * j)), k, std::to_string(9 * j) + "-digit n");
+    }
+  }
+
+  // degenerate orders and radicands
+  const int2048 big(check::digits(rng, 500));
+  check::expect(iroot(big, 1) == big && iroot(-big, 1) == -big, "k = 1");
+  check::expect(iroot(big, 1ull << 40) == 1 && iroot(-big, (1ull << 40) + 1) == -1, "huge k");
+  const int2048 zero(0), one(1);
+  check::expect(isqrt(zero) == 0 && isqrt(one) == 1 && iroot(zero, 5) == 0, "0 and 1");
+  check::expect(isqrt(-big) == 0 && iroot(big, 0) == 0, "undefined inputs give 0");
+  return check::summary("root_test");
+}